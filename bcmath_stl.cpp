@@ -1,833 +1,3502 @@
-/*
-    This file is part of VK/KittenPHP-DB-Engine.
-
-    VK/KittenPHP-DB-Engine is free software: you can redistribute it and/or modify
-    it under the terms of the GNU General Public License as published by
-    the Free Software Foundation, either version 2 of the License, or
-    (at your option) any later version.
-
-    VK/KittenPHP-DB-Engine is distributed in the hope that it will be useful,
-    but WITHOUT ANY WARRANTY; without even the implied warranty of
-    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-    GNU General Public License for more details.
-
-    You should have received a copy of the GNU General Public License
-    along with VK/KittenPHP-DB-Engine.  If not, see <http://www.gnu.org/licenses/>.
-
-    This program is released under the GPL with the additional exemption
-    that compiling, linking, and/or using OpenSSL is allowed.
-    You are free to remove this exemption from derived works.
-
-    Copyright 2012-2013 Vkontakte Ltd
-              2012-2013 Arseny Smirnov
-              2012-2013 Aliaksei Levin
-
-    URL: https://github.com/vk-com/kphp-kdb/blob/master/KPHP/runtime/bcmath.cpp
-
-    Adapted to STL C++:
-        2014 Kijam Lopez B. <klopez@cuado.co>
-*/
-
-
-#define BC_ASSERT(cond) ((!(cond)) ? bc_assert(#cond,__FILE__,__LINE__) : bc_noassert())
-
-#include "bcmath_stl.h"
-#include <string.h>
-#include <stdlib.h>
-
-static int bc_scale = 6;
-
-static const std::string ONE ("1");
-static const std::string ZERO ("0");
-
-static void bc_noassert() { }
-static void bc_assert(const char *assertion, const char *file, int line) {
-    std::cerr<<"Critical Error in: "<<assertion<<", File '"<<file<<"' in line "<<line<<"."<<std::endl;
-    exit(-1);
-}
-
-//parse a number into parts, returns scale on success and -1 on error
-static int bc_parse_number (const std::string &s, int &lsign, int &lint, int &ldot, int &lfrac, int &lscale) {
-  int i = 0;
-  lsign = 1;
-  if (s[i] == '-' || s[i] == '+') {
-    if (s[i] == '-') {
-      lsign = -1;
-    }
-    i++;
-  }
-  int len = s.length();
-  if (i >= len) {
-    return -1;
-  }
-  lint = i;
-
-  while (i < len && '0' <= s[i] && s[i] <= '9') {
-    i++;
-  }
-  ldot = i;
-
-  lscale = 0;
-  if (i < len && s[i] == '.') {
-    lscale = (int)s.length() - i - 1;
-    i++;
-  }
-  lfrac = i;
-
-  while (i < len && '0' <= s[i] && s[i] <= '9') {
-    i++;
-  }
-
-  if (i < len) {
-    return -1;
-  }
-
-  while (s[lint] == '0' && lint + 1 < ldot) {
-    lint++;
-  }
-//  while (lscale > 0 && s[lfrac + lscale - 1] == '0') {
-//    lscale--;
-//  }
-  if (lscale == 0 && lfrac > ldot) {
-    lfrac--;
-    BC_ASSERT (lfrac == ldot);
-  }
-
-  if (lsign < 0 && (lscale == 0 && s[lint] == '0')) {
-    lsign = 1;
-  }
-  return lscale;
-}
-
-static std::string bc_zero (int scale) {
-  if (scale == 0) {
-    return ZERO;
-  }
-  std::string result (scale + 2, '0');
-  result[1] = '.';
-  return result;
-}
-
-static int bc_comp (const char *lhs, int lint, int ldot, int lfrac, int lscale, const char *rhs, int rint, int rdot, int rfrac, int rscale, int scale) {
-  int llen = ldot - lint;
-  int rlen = rdot - rint;
-
-  if (llen != rlen) {
-    return (llen < rlen ? -1 : 1);
-  }
-
-  for (int i = 0; i < llen; i++) {
-    if (lhs[lint + i] != rhs[rint + i]) {
-      return (lhs[lint + i] < rhs[rint + i] ? -1 : 1);
-    }
-  }
-
-  int i;
-  for (i = 0; (i < lscale || i < rscale) && i < scale; i++) {
-    int lchar = (i < lscale ? lhs[lfrac + i] : '0');
-    int rchar = (i < rscale ? rhs[rfrac + i] : '0');
-    if (lchar != rchar) {
-      return (lchar < rchar ? -1 : 1);
-    }
-  }
-
-  return 0;
-}
-
-static std::string bc_round (char *lhs, int lint, int ldot, int lfrac, int lscale, int scale, int sign, bool add_trailing_zeroes, bool round_last = false) {
-  while (lhs[lint] == '0' && lint + 1 < ldot) {
-    lint++;
-  }
-
-  BC_ASSERT (lint > 0 && lscale >= 0 && scale >= 0);
-
-  if (sign < 0 && lhs[lint] == '0') {
-    sign = 1;
-    for (int i = 0; i < lscale; i++) {
-      if (lhs[lfrac + i] != '0') {
-        sign = -1;
-        break;
-      }
-    }
-  }
-
-  if(round_last) {
-      if (lscale > scale) {
-        while (scale > 0 && lhs[lfrac + scale - 1] == '9' && lhs[lfrac + scale] >= '5') {
-          scale--;
-        }
-        lscale = scale;
-        if (lhs[lfrac + scale] >= '5') {
-          if (scale > 0) {
-            lhs[lfrac + scale - 1]++;
-          } else {
-            lfrac--;
-            BC_ASSERT (lfrac == ldot);
-
-            int i;
-            lhs[lint - 1] = '0';
-            for (i = 0; lhs[ldot - i - 1] == '9'; i++) {
-              lhs[ldot - i - 1] = '0';
-            }
-            lhs[ldot - i - 1]++;
-            if (ldot - i - 1 < lint) {
-              lint = ldot - i - 1;
-            }
-          }
-        }
-      }
-
-      while (lscale > 0 && lhs[lfrac + lscale - 1] == '0') {
-        lscale--;
-      }
-  }else{
-      if (lscale > scale) {
-        lscale = scale;
-      }
-  }
-
-  if (lscale == 0 && lfrac > ldot) {
-    lfrac--;
-    BC_ASSERT (lfrac == ldot);
-  }
-
-  if (sign < 0) {
-    lhs[--lint] = '-';
-  }
-
-  if (lscale == scale || !add_trailing_zeroes) {
-    return std::string (std::string(lhs + lint).substr(0, lfrac + lscale - lint));
-  } else {
-    std::string result (std::string(lhs + lint).substr(0, lfrac + lscale - lint));
-    if (lscale == 0) {
-      result+='.';
-    }
-    for(int kI = 0; kI < scale - lscale; ++kI)
-        result+='0';
-    return result;
-  }
-}
-
-static std::string bc_add_positive (const char *lhs, int lint, int ldot, int lfrac, int lscale, const char *rhs, int rint, int rdot, int rfrac, int rscale, int scale, int sign) {
-  int llen = ldot - lint;
-  int rlen = rdot - rint;
-
-  int resint, resdot, resfrac, resscale;
-
-  int result_len = std::max (llen, rlen) + 1;
-  int result_scale = std::max (lscale, rscale);
-  int result_size = result_len + result_scale + 3;
-  std::string result(result_size, '0');
-
-  int i, um = 0;
-  int cur_pos = result_size;
-  int was_frac = 0;
-  for (i = result_scale - 1; i >= 0; i--) {
-    if (i < lscale) {
-      um += lhs[lfrac + i] - '0';
-    }
-    if (i < rscale) {
-      um += rhs[rfrac + i] - '0';
-    }
-
-    if (um != 0 || was_frac) {
-      result[--cur_pos] = (char)(um % 10 + '0');
-      um /= 10;
-      was_frac = 1;
-    }
-  }
-  resscale = result_size - cur_pos;
-  resfrac = cur_pos;
-  if (was_frac) {
-    result[--cur_pos] = '.';
-  }
-  resdot = cur_pos;
-
-  for (int i = 0; i < result_len; i++) {
-    if (i < llen) {
-      um += lhs[ldot - i - 1] - '0';
-    }
-    if (i < rlen) {
-      um += rhs[rdot - i - 1] - '0';
-    }
-
-    result[--cur_pos] = (char)(um % 10 + '0');
-    um /= 10;
-  }
-  resint = cur_pos;
-  BC_ASSERT (cur_pos > 0);
-
-  return bc_round ((char*)result.data(), resint, resdot, resfrac, resscale, scale, sign, 1);
-}
-
-static std::string bc_sub_positive (const char *lhs, int lint, int ldot, int lfrac, int lscale, const char *rhs, int rint, int rdot, int rfrac, int rscale, int scale, int sign) {
-  int llen = ldot - lint;
-  int rlen = rdot - rint;
-
-  int resint, resdot, resfrac, resscale;
-
-  int result_len = llen;
-  int result_scale = std::max (lscale, rscale);
-  int result_size = result_len + result_scale + 3;
-  std::string result (result_size, '0');
-
-  int i, um = 0, next_um = 0;
-  int cur_pos = result_size;
-  int was_frac = 0;
-  for (i = result_scale - 1; i >= 0; i--) {
-    um = next_um;
-    if (i < lscale) {
-      um += lhs[lfrac + i] - '0';
-    }
-    if (i < rscale) {
-      um -= rhs[rfrac + i] - '0';
-    }
-    if (um < 0) {
-      next_um = -1;
-      um += 10;
-    } else {
-      next_um = 0;
-    }
-
-    if (um != 0 || was_frac) {
-      result[--cur_pos] = (char)(um + '0');
-      was_frac = 1;
-    }
-  }
-  resscale = result_size - cur_pos;
-  resfrac = cur_pos;
-  if (was_frac) {
-    result[--cur_pos] = '.';
-  }
-  resdot = cur_pos;
-
-  for (int i = 0; i < result_len; i++) {
-    um = next_um;
-    um += lhs[ldot - i - 1] - '0';
-    if (i < rlen) {
-      um -= rhs[rdot - i - 1] - '0';
-    }
-    if (um < 0) {
-      next_um = -1;
-      um += 10;
-    } else {
-      next_um = 0;
-    }
-
-    result[--cur_pos] = (char)(um + '0');
-  }
-  resint = cur_pos;
-  BC_ASSERT (cur_pos > 0);
-
-  return bc_round ((char*)result.data(), resint, resdot, resfrac, resscale, scale, sign, 1);
-}
-
-static std::string bc_mul_positive (const char *lhs, int lint, int ldot, int lfrac, int lscale, const char *rhs, int rint, int rdot, int rfrac, int rscale, int scale, int sign) {
-  int llen = ldot - lint;
-  int rlen = rdot - rint;
-
-  int resint, resdot, resfrac, resscale;
-
-  int result_len = llen + rlen;
-  int result_scale = lscale + rscale;
-  int result_size = result_len + result_scale + 3;
-  std::string result (result_size, '0');
-
-  int *res = (int *)malloc(sizeof (int) * result_size);
-  memset(res, 0, sizeof (int) * result_size);
-  for (int i = -lscale; i < llen; i++) {
-    int x = (i < 0 ? lhs[lfrac - i - 1] : lhs[ldot - i - 1]) - '0';
-    for (int j = -rscale; j < rlen; j++) {
-      int y = (j < 0 ? rhs[rfrac - j - 1] : rhs[rdot - j - 1]) - '0';
-      res[i + j + result_scale] += x * y;
-    }
-  }
-  for (int i = 0; i + 1 < result_size; i++) {
-    res[i + 1] += res[i] / 10;
-    res[i] %= 10;
-  }
-
-  int cur_pos = result_size;
-  for (int i = 0; i < result_scale; i++) {
-    result[--cur_pos] = (char)(res[i] + '0');
-  }
-  resscale = result_size - cur_pos;
-  resfrac = cur_pos;
-  if (result_scale > 0) {
-    result[--cur_pos] = '.';
-  }
-  resdot = cur_pos;
-
-  for (int i = result_scale; i < result_len + result_scale; i++) {
-    result[--cur_pos] = (char)(res[i] + '0');
-  }
-  resint = cur_pos;
-  BC_ASSERT (cur_pos > 0);
-
-  free(res);
-
-  char *data = (char*)malloc((result.length()+1)*sizeof(char));
-  sprintf(data, result.c_str());
-  std::string ret = bc_round (data, resint, resdot, resfrac, resscale, scale, sign, 0);
-  free(data);
-
-  return ret;
-}
-
-static std::string bc_div_positive (const char *lhs, int lint, int ldot, int lfrac, int lscale, const char *rhs, int rint, int rdot, int rfrac, int rscale, int scale, int sign) {
-  int llen = ldot - lint;
-  int rlen = rdot - rint;
-
-  int resint, resdot = -1, resfrac = -1, resscale;
-
-  int result_len = std::max (llen + rscale - rlen + 1, 1);
-  int result_scale = scale;
-  int result_size = result_len + result_scale + 3;
-
-  if (rscale == 0 && rhs[rint] == '0') {
-    std::cerr << ("Division by zero in function bcdiv")<< std::endl<< std::endl;
-    return ZERO;
-  }
-
-  int dividend_len = llen + lscale;
-  int divider_len = rlen + rscale;
-  int *dividend = (int *)malloc(sizeof (int) * (result_size + dividend_len + divider_len));
-  int *divider = (int *)malloc(sizeof (int) * divider_len);
-  memset(dividend, 0, sizeof (int) * (result_size + dividend_len + divider_len));
-  memset(divider, 0, sizeof (int) * divider_len);
-
-  for (int i = -lscale; i < llen; i++) {
-    int x = (i < 0 ? lhs[lfrac - i - 1] : lhs[ldot - i - 1]) - '0';
-    dividend[llen - i - 1] = x;
-  }
-
-  for (int i = -rscale; i < rlen; i++) {
-    int x = (i < 0 ? rhs[rfrac - i - 1] : rhs[rdot - i - 1]) - '0';
-    divider[rlen - i - 1] = x;
-  }
-
-  int divider_skip = 0;
-  while (divider_len > 0 && divider[0] == 0) {
-    divider++;
-    divider_skip++;
-    divider_len--;
-  }
-  BC_ASSERT (divider_len > 0);
-
-  int cur_pow = llen - rlen + divider_skip;
-  int cur_pos = 2;
-
-  if (cur_pow < -scale) {
-    divider -= divider_skip;
-    divider_len += divider_skip;
-    free(dividend);
-    free(divider);
-    return bc_zero (scale);
-  }
-
-  std::string result (result_size, '0');
-  resint = cur_pos;
-  if (cur_pow < 0) {
-    result[cur_pos++] = '0';
-    resdot = cur_pos;
-    result[cur_pos++] = '.';
-    resfrac = cur_pos;
-    for (int i = -1; i > cur_pow; i--) {
-      result[cur_pos++] = '0';
-    }
-  }
-
-  int beg = 0, real_beg = 0;
-  while (cur_pow >= -scale) {
-    char dig = '0';
-    while (true) {
-      if (real_beg < beg && dividend[real_beg] == 0) {
-        real_beg++;
-      }
-
-      bool less = false;
-      if (real_beg == beg) {
-        for (int i = 0; i < divider_len; i++) {
-          if (dividend[beg + i] != divider[i]) {
-            less = (dividend[beg + i] < divider[i]);
-            break;
-          }
-        }
-      }
-      if (less) {
-        break;
-      }
-
-      for (int i = divider_len - 1; i >= 0; i--) {
-        dividend[beg + i] -= divider[i];
-        if (dividend[beg + i] < 0) {
-          dividend[beg + i] += 10;
-          dividend[beg + i - 1]--;
-        }
-      }
-      dig++;
-    }
-
-    result[cur_pos++] = dig;
-
-    if (cur_pow == 0) {
-      resdot = cur_pos;
-      if (scale > 0) {
-        result[cur_pos++] = '.';
-      }
-      resfrac = cur_pos;
-    }
-    cur_pow--;
-    beg++;
-  }
-  resscale = cur_pos - resfrac;
-
-  divider -= divider_skip;
-  divider_len += divider_skip;
-  free(dividend);
-  free(divider);
-
-  char *data = (char*)malloc((result.length()+1)*sizeof(char));
-  sprintf(data, result.c_str());
-  std::string ret = bc_round (data, resint, resdot, resfrac, resscale, scale, sign, 0);
-  free(data);
-
-  return ret;
-}
-
-
-static std::string bc_add (const char *lhs, int lsign, int lint, int ldot, int lfrac, int lscale, const char *rhs, int rsign, int rint, int rdot, int rfrac, int rscale, int scale) {
-  if (lsign > 0 && rsign > 0) {
-    return bc_add_positive (lhs, lint, ldot, lfrac, lscale, rhs, rint, rdot, rfrac, rscale, scale, 1);
-  }
-
-  if (lsign > 0 && rsign < 0) {
-    if (bc_comp (lhs, lint, ldot, lfrac, lscale, rhs, rint, rdot, rfrac, rscale, 1000000000) >= 0) {
-      return bc_sub_positive (lhs, lint, ldot, lfrac, lscale, rhs, rint, rdot, rfrac, rscale, scale, 1);
-    } else {
-      return bc_sub_positive (rhs, rint, rdot, rfrac, rscale, lhs, lint, ldot, lfrac, lscale, scale, -1);
-    }
-  }
-
-  if (lsign < 0 && rsign > 0) {
-    if (bc_comp (lhs, lint, ldot, lfrac, lscale, rhs, rint, rdot, rfrac, rscale, 1000000000) <= 0) {
-      return bc_sub_positive (rhs, rint, rdot, rfrac, rscale, lhs, lint, ldot, lfrac, lscale, scale, 1);
-    } else {
-      return bc_sub_positive (lhs, lint, ldot, lfrac, lscale, rhs, rint, rdot, rfrac, rscale, scale, -1);
-    }
-  }
-
-  if (lsign < 0 && rsign < 0) {
-    return bc_add_positive (lhs, lint, ldot, lfrac, lscale, rhs, rint, rdot, rfrac, rscale, scale, -1);
-  }
-
-  BC_ASSERT (0);
-  return ZERO; //Is dummy...
-}
-
-void BCMath::bcscale (int scale) {
-  if (scale < 0) {
-    bc_scale = 0;
-  } else {
-    bc_scale = scale;
-  }
-}
-
-std::string BCMath::bcdiv (const std::string &lhs, const std::string &rhs, int scale) {
-  if (scale == INT_MIN) {
-    scale = bc_scale;
-  }
-  if (scale < 0) {
-    std::cerr << "Wrong parameter scale = "<<scale<<" in function bcdiv"<< std::endl;
-    scale = 0;
-  }
-  if (lhs.empty()) {
-    return bc_zero (scale);
-  }
-  if (rhs.empty()) {
-    std::cerr << "Division by empty "<<  rhs.c_str() <<" in function bcdiv"<< std::endl;
-    return bc_zero (scale);
-  }
-
-  int lsign, lint, ldot, lfrac, lscale;
-  if (bc_parse_number (lhs, lsign, lint, ldot, lfrac, lscale) < 0) {
-    std::cerr << "First parameter \""<<  lhs.c_str() <<"\" in function bcdiv is not a number"<< std::endl;
-    return ZERO;
-  }
-
-  int rsign, rint, rdot, rfrac, rscale;
-  if (bc_parse_number (rhs, rsign, rint, rdot, rfrac, rscale) < 0) {
-    std::cerr << "Second parameter \""<< rhs.c_str() <<"\" in function bcdiv is not a number"<< std::endl;
-    return ZERO;
-  }
-
-  return bc_div_positive (lhs.c_str(), lint, ldot, lfrac, lscale, rhs.c_str(), rint, rdot, rfrac, rscale, scale, lsign * rsign);
-}
-
-std::string BCMath::bcmod (const std::string &lhs, const std::string &rhs) {
-  if (lhs.empty()) {
-    return ZERO;
-  }
-  if (rhs.empty()) {
-    std::cerr << "Modulo by empty "<<  rhs.c_str() <<" in function bcmod"<< std::endl;
-    return ZERO;
-  }
-
-  int lsign, lint, ldot, lfrac, lscale;
-  if (bc_parse_number (lhs, lsign, lint, ldot, lfrac, lscale) != 0) {
-    std::cerr << "First parameter \""<< lhs.c_str() <<"\" in function bcmod is not an integer"<< std::endl;
-    return ZERO;
-  }
-
-  int rsign, rint, rdot, rfrac, rscale;
-  if (bc_parse_number (rhs, rsign, rint, rdot, rfrac, rscale) != 0) {
-    std::cerr << "Second parameter \""<< rhs.c_str() <<"\" in function bcmod is not an integer"<< std::endl;
-    return ZERO;
-  }
-
-  long long mod = 0;
-  for (int i = rint; i < rdot; i++) {
-    mod = mod * 10 + rhs[i] - '0';
-  }
-
-  if (rdot - rint > 18 || mod == 0) {
-    std::cerr << "Second parameter \""<< rhs.c_str() <<"\" in function bcmod is not a non zero integer less than 1e18 by absolute value"<< std::endl;
-    return ZERO;
-  }
-
-  long long res = 0;
-  for (int i = lint; i < ldot; i++) {
-    res = res * 2;
-    if (res >= mod) {
-      res -= mod;
-    }
-    res = res * 5 + lhs[i] - '0';
-    while (res >= mod) {
-      res -= mod;
-    }
-  }
-
-  char buffer[20];
-  int cur_pos = 20;
-  do {
-    buffer[--cur_pos] = (char)(res % 10 + '0');
-    res /= 10;
-  } while (res > 0);
-
-  if (lsign < 0) {
-    buffer[--cur_pos] = '-';
-  }
-
-  return std::string(std::string(buffer + cur_pos).substr(0, 20 - cur_pos));
-}
-
-std::string BCMath::bcpow (const std::string &lhs, const std::string &rhs) {
-  if (lhs.empty()) {
-    return ZERO;
-  }
-  if (rhs.empty()) {
-    return ONE;
-  }
-
-  int lsign, lint, ldot, lfrac, lscale;
-  if (bc_parse_number (lhs, lsign, lint, ldot, lfrac, lscale) != 0) {
-    std::cerr << "First parameter \""<<lhs.c_str()<<"\" in function bcpow is not an integer"<< std::endl;
-    return ZERO;
-  }
-
-  int rsign, rint, rdot, rfrac, rscale;
-  if (bc_parse_number (rhs, rsign, rint, rdot, rfrac, rscale) != 0) {
-    std::cerr << "Second parameter \""<< rhs.c_str() <<"\" in function bcpow is not an integer"<< std::endl;
-    return ZERO;
-  }
-
-  long long deg = 0;
-  for (int i = rint; i < rdot; i++) {
-    deg = deg * 10 + rhs[i] - '0';
-  }
-
-  if (rdot - rint > 18 || (rsign < 0 && deg != 0)) {
-    std::cerr << "Second parameter \""<< rhs.c_str() <<"\" in function bcpow is not a non negative integer less than 1e18"<< std::endl;
-    return ZERO;
-  }
-
-  if (deg == 0) {
-    return ONE;
-  }
-
-  std::string result = ONE;
-  std::string mul = lhs;
-  while (deg > 0) {
-    if (deg & 1) {
-      result = bcmul (result, mul, 0);
-    }
-    mul = bcmul (mul, mul, 0);
-    deg >>= 1;
-  }
-
-  return result;
-}
-
-std::string BCMath::bcadd (const std::string &lhs, const std::string &rhs, int scale) {
-  if (lhs.empty()) {
-    return bcadd (ZERO, rhs, scale);
-  }
-  if (rhs.empty()) {
-    return bcadd (lhs, ZERO, scale);
-  }
-
-  if (scale == INT_MIN) {
-    scale = bc_scale;
-  }
-  if (scale < 0) {
-    std::cerr << "Wrong parameter scale = "<< scale <<" in function bcadd"<< std::endl;
-    scale = 0;
-  }
-
-  int lsign, lint, ldot, lfrac, lscale;
-  if (bc_parse_number (lhs, lsign, lint, ldot, lfrac, lscale) < 0) {
-    std::cerr << "First parameter \""<< lhs.c_str() << "\" in function bcadd is not a number"<< std::endl;
-    return bc_zero (scale);
-  }
-
-  int rsign, rint, rdot, rfrac, rscale;
-  if (bc_parse_number (rhs, rsign, rint, rdot, rfrac, rscale) < 0) {
-    std::cerr << "Second parameter \""<< rhs.c_str() << "\" in function bcadd is not a number"<< std::endl;
-    return bc_zero (scale);
-  }
-
-  return bc_add (lhs.c_str(), lsign, lint, ldot, lfrac, lscale, rhs.c_str(), rsign, rint, rdot, rfrac, rscale, scale);
-}
-
-std::string BCMath::bcsub (const std::string &lhs, const std::string &rhs, int scale) {
-  if (lhs.empty()) {
-    return bcsub (ZERO, rhs, scale);
-  }
-  if (rhs.empty()) {
-    return bcsub (lhs, ZERO, scale);
-  }
-
-  if (scale == INT_MIN) {
-    scale = bc_scale;
-  }
-  if (scale < 0) {
-    std::cerr << "Wrong parameter scale = "<< scale <<" in function bcsub"<< std::endl;
-    scale = 0;
-  }
-
-  int lsign, lint, ldot, lfrac, lscale;
-  if (bc_parse_number (lhs, lsign, lint, ldot, lfrac, lscale) < 0) {
-    std::cerr << "First parameter \""<<lhs.c_str()<<"\" in function bcsub is not a number"<< std::endl;
-    return bc_zero (scale);
-  }
-
-  int rsign, rint, rdot, rfrac, rscale;
-  if (bc_parse_number (rhs, rsign, rint, rdot, rfrac, rscale) < 0) {
-    std::cerr << "Second parameter \""<<rhs.c_str()<<"\" in function bcsub is not a number"<< std::endl;
-    return bc_zero (scale);
-  }
-
-  rsign *= -1;
-
-  return bc_add (lhs.c_str(), lsign, lint, ldot, lfrac, lscale, rhs.c_str(), rsign, rint, rdot, rfrac, rscale, scale);
-}
-
-std::string BCMath::bcmul (const std::string &lhs, const std::string &rhs, int scale) {
-  if (lhs.empty()) {
-    return bcmul (ZERO, rhs, scale);
-  }
-  if (rhs.empty()) {
-    return bcmul (lhs, ZERO, scale);
-  }
-
-  if (scale == INT_MIN) {
-    scale = bc_scale;
-  }
-  if (scale < 0) {
-    std::cerr << "Wrong parameter scale = "<<scale<<" in function bcmul"<< std::endl;
-    scale = 0;
-  }
-
-  int lsign, lint, ldot, lfrac, lscale;
-  if (bc_parse_number (lhs, lsign, lint, ldot, lfrac, lscale) < 0) {
-    std::cerr << "First parameter \""<<lhs.c_str()<<"\" in function bcmul is not a number"<< std::endl;
-    return ZERO;
-  }
-
-  int rsign, rint, rdot, rfrac, rscale;
-  if (bc_parse_number (rhs, rsign, rint, rdot, rfrac, rscale) < 0) {
-    std::cerr << "Second parameter \""<<rhs.c_str()<<"\" in function bcmul is not a number"<< std::endl;
-    return ZERO;
-  }
-
-  return bc_mul_positive (lhs.c_str(), lint, ldot, lfrac, lscale, rhs.c_str(), rint, rdot, rfrac, rscale, scale, lsign * rsign);
-}
-
-int BCMath::bccomp (const std::string &lhs, const std::string &rhs, int scale) {
-  if (lhs.empty()) {
-    return BCMath::bccomp (ZERO, rhs, scale);
-  }
-  if (rhs.empty()) {
-    return BCMath::bccomp (lhs, ZERO, scale);
-  }
-
-  if (scale == INT_MIN) {
-    scale = bc_scale;
-  }
-  if (scale < 0) {
-    std::cerr << "Wrong parameter scale = "<<scale<<" in function bccomp"<< std::endl;
-    scale = 0;
-  }
-
-  int lsign, lint, ldot, lfrac, lscale;
-  if (bc_parse_number (lhs, lsign, lint, ldot, lfrac, lscale) < 0) {
-    std::cerr << "First parameter \""<<lhs.c_str()<<"\" in function bccomp is not a number"<< std::endl;
-    return 0;
-  }
-
-  int rsign, rint, rdot, rfrac, rscale;
-  if (bc_parse_number (rhs, rsign, rint, rdot, rfrac, rscale) < 0) {
-    std::cerr << "Second parameter \""<<rhs.c_str()<<"\" in function bccomp is not a number"<< std::endl;
-    return 0;
-  }
-
-  if (lsign != rsign) {
-    return (lsign - rsign) / 2;
-  }
-
-  return (1 - 2 * (lsign < 0)) * bc_comp (lhs.c_str(), lint, ldot, lfrac, lscale, rhs.c_str(), rint, rdot, rfrac, rscale, scale);
-}
-
-std::string BCMath::bcround (const std::string &lhs, int scale) {
-    if (lhs.empty()) {
-      return BCMath::bcround (ZERO, scale);
-    }
-
-    if (scale == INT_MIN) {
-      scale = bc_scale;
-    }
-
-    if (scale < 0) {
-      std::cerr << "Wrong parameter scale = "<<scale<<" in function bccomp"<< std::endl;
-      scale = 0;
-    }
-
-    int lsign, lint, ldot, lfrac, lscale;
-    if (bc_parse_number (lhs, lsign, lint, ldot, lfrac, lscale) < 0) {
-      std::cerr << "First parameter \""<<lhs.c_str()<<"\" in function bcround is not a number"<< std::endl;
-      return 0;
-    }
-
-    int len = lhs.size();
-    std::string result(len + 1, '0');
-    for(int i = len-1;i>=lint;--i) {
-        result[i+1] = lhs[i];
-    }
-
-    char *data = (char*)malloc((result.length()+1)*sizeof(char));
-    sprintf(data, result.c_str());
-    std::string ret = bc_round (data, lint+1, ldot+1, lfrac+1, lscale, scale, lsign, 1, 1);
-    free(data);
-
-    return ret;
-}
+/*
+    This file is part of VK/KittenPHP-DB-Engine.
+
+    VK/KittenPHP-DB-Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    VK/KittenPHP-DB-Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VK/KittenPHP-DB-Engine.  If not, see <http://www.gnu.org/licenses/>.
+
+    This program is released under the GPL with the additional exemption
+    that compiling, linking, and/or using OpenSSL is allowed.
+    You are free to remove this exemption from derived works.
+
+    Copyright 2012-2013 Vkontakte Ltd
+              2012-2013 Arseny Smirnov
+              2012-2013 Aliaksei Levin
+
+    URL: https://github.com/vk-com/kphp-kdb/blob/master/KPHP/runtime/bcmath.cpp
+
+    Adapted to STL C++:
+        2014 Kijam Lopez B. <klopez@cuado.co>
+*/
+
+
+#define BC_ASSERT(cond) ((!(cond)) ? bc_assert(#cond,__FILE__,__LINE__) : bc_noassert())
+
+#include "bcmath_stl.h"
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <stdexcept>
+#include <deque>
+#include <limits>
+#include <cmath>
+#include <clocale>
+#include <stdio.h>
+
+//vector kernels for x86, picked at run time from CPUID; every kernel has a scalar fallback
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BC_SIMD_X86
+#include <immintrin.h>
+#endif
+
+static BCMath::Context bc_default_context (6);
+static thread_local const BCMath::Context *bc_context = NULL;
+
+static const std::string ONE ("1");
+static const std::string ZERO ("0");
+
+static void bc_noassert() { }
+static void bc_assert(const char *assertion, const char *file, int line) {
+    std::cerr<<"Critical Error in: "<<assertion<<", File '"<<file<<"' in line "<<line<<"."<<std::endl;
+    exit(-1);
+}
+
+static const bc_limb BC_BASE = 1000000000;
+static const int BC_BASE_DIGITS = 9;
+
+//operand size in limbs from which multiplication switches from schoolbook to Karatsuba
+static const int BC_KARATSUBA_THRESHOLD = 96;
+
+//operand size in limbs from which multiplication switches from Karatsuba to the number-theoretic transform
+static const int BC_NTT_THRESHOLD = 6000;
+
+//columns computed below the lowest kept limb by a truncated multiplication
+static const int BC_MUL_GUARD = 3;
+
+//operand size in limbs from which squaring switches from schoolbook to Karatsuba
+static const int BC_SQR_KARATSUBA_THRESHOLD = 96;
+
+//divisor size in limbs from which a prepared divisor keeps a full reciprocal and
+//divides by Barrett reduction instead of long division
+static const int BC_BARRETT_THRESHOLD = 200;
+
+//divisor and quotient size in limbs from which division goes through a Newton
+//reciprocal, and the reciprocal size computed directly by long division
+static const int BC_NEWTON_THRESHOLD = 1200;
+static const int BC_NEWTON_BASECASE = 64;
+
+//additions an accumulator takes before it resolves its carries; a column starts
+//in (-BC_BASE, BC_BASE) and moves by less than BC_BASE per addition, so it stays
+//below (BC_ACC_PENDING + 1) * BC_BASE < 2^63
+static const unsigned long long BC_ACC_PENDING = 1ULL << 32;
+
+//first byte of the binary form of serialize, changed whenever the layout is
+static const unsigned char BC_ENCODING_VERSION = 1;
+
+//escapes in the second byte of the binary form, which holds the sign, the number of
+//integer limbs below BC_HEAD_INTS and the scale below BC_HEAD_SCALE; larger ones
+//follow as varints
+static const int BC_HEAD_INTS = 7;
+static const int BC_HEAD_SCALE = 15;
+
+//first byte of a key, so that negative numbers come before zero and zero before
+//positive numbers
+static const unsigned char BC_KEY_NEGATIVE = 0x10;
+static const unsigned char BC_KEY_ZERO = 0x20;
+static const unsigned char BC_KEY_POSITIVE = 0x30;
+
+//added to the limbs of a key, so that their first byte is never 0x00 or 0xff,
+//the terminators of positive and negative keys
+static const unsigned int BC_KEY_LIMB = 0x40000000;
+
+//buckets of at most this many keys are sorted by insertion
+static const size_t BC_RADIX_THRESHOLD = 32;
+
+#ifdef BC_SIMD_X86
+static bool bc_cpu_supports (int feature) {
+  __builtin_cpu_init ();
+  return (feature == 2 ? __builtin_cpu_supports ("avx2") : __builtin_cpu_supports ("sse4.1"));
+}
+
+static const bool bc_has_sse41 = bc_cpu_supports (1);
+static const bool bc_has_avx2 = bc_cpu_supports (2);
+#endif
+
+//size in bytes of the first block of a scratch arena, later blocks double
+static const size_t BC_ARENA_BLOCK = 1 << 16;
+
+//per-thread scratch memory of the kernels: memory is handed out in stack order
+//through bc_scratch frames and the blocks are kept until the thread exits, so
+//once they have grown to the working set the kernels do not allocate
+struct bc_arena {
+  std::vector<std::pair<char *, size_t> > blocks;
+  size_t block;
+  size_t used;
+
+  bc_arena () : block (0), used (0) { }
+
+  ~bc_arena () {
+    for (size_t i = 0; i < blocks.size(); i++) {
+      free (blocks[i].first);
+    }
+  }
+
+  void *take (size_t bytes) {
+    bytes = (bytes + 31) & ~(size_t)31;
+    while (block < blocks.size() && used + bytes > blocks[block].second) {
+      block++;
+      used = 0;
+    }
+    if (block == blocks.size()) {
+      size_t size = std::max (bytes, blocks.empty() ? BC_ARENA_BLOCK : 2 * blocks.back().second);
+      char *data = (char *)malloc (size);
+      BC_ASSERT (data != NULL);
+      blocks.push_back (std::make_pair (data, size));
+    }
+    void *res = blocks[block].first + used;
+    used += bytes;
+    return res;
+  }
+};
+
+static thread_local bc_arena bc_thread_arena;
+
+//operands and results of the string functions live in these, so their limb
+//buffers are reused from call to call
+static thread_local bc_num bc_lhs, bc_rhs, bc_res;
+
+//scratch frame: everything taken through it is given back to the arena when it
+//goes out of scope
+class bc_scratch {
+public:
+  bc_scratch () : arena (bc_thread_arena), block (arena.block), used (arena.used) { }
+
+  ~bc_scratch () {
+    arena.block = block;
+    arena.used = used;
+  }
+
+  template <typename T>
+  T *take (size_t n) {
+    return (T *)arena.take (sizeof (T) * n);
+  }
+
+  template <typename T>
+  T *zeros (size_t n) {
+    T *res = take<T> (n);
+    memset (res, 0, sizeof (T) * n);
+    return res;
+  }
+
+private:
+  bc_arena &arena;
+  size_t block;
+  size_t used;
+
+  bc_scratch (const bc_scratch &);
+  bc_scratch &operator= (const bc_scratch &);
+};
+
+static const bc_limb bc_pow10[BC_BASE_DIGITS + 1] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static int bc_frac_limbs (int scale) {
+  return (scale + BC_BASE_DIGITS - 1) / BC_BASE_DIGITS;
+}
+
+static int bc_int_limbs (const bc_num &num) {
+  return (int)num.limbs.size() - bc_frac_limbs (num.scale);
+}
+
+static int bc_limb_digits (bc_limb x) {
+  int len = 1;
+  while (len < BC_BASE_DIGITS && x >= bc_pow10[len]) {
+    len++;
+  }
+  return len;
+}
+
+//number of digits in the integer part, 0 if it is zero
+static int bc_int_digits (const bc_num &num) {
+  int len = bc_int_limbs (num);
+  if (len == 0) {
+    return 0;
+  }
+  return (len - 1) * BC_BASE_DIGITS + bc_limb_digits (num.limbs.back());
+}
+
+//digit standing at 10^pow
+static int bc_digit (const bc_num &num, int pow) {
+  int pos = pow + bc_frac_limbs (num.scale) * BC_BASE_DIGITS;
+  if (pos < 0 || pos >= (int)num.limbs.size() * BC_BASE_DIGITS) {
+    return 0;
+  }
+  return num.limbs[pos / BC_BASE_DIGITS] / bc_pow10[pos % BC_BASE_DIGITS] % 10;
+}
+
+static bool bc_is_zero (const bc_limb *a, int len) {
+  for (int i = 0; i < len; i++) {
+    if (a[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool bc_is_zero (const bc_num &num) {
+  return bc_is_zero (num.limbs.data(), (int)num.limbs.size());
+}
+
+//length of a without leading zero limbs
+static int bc_trim (const bc_limb *a, int len) {
+  while (len > 0 && a[len - 1] == 0) {
+    len--;
+  }
+  return len;
+}
+
+//drops leading zero limbs of the integer part
+static void bc_strip (bc_num &num) {
+  int frac = bc_frac_limbs (num.scale);
+  while ((int)num.limbs.size() > frac && num.limbs.back() == 0) {
+    num.limbs.pop_back();
+  }
+}
+
+//len limbs of a magnitude, frac of which are fractional
+struct bc_mag {
+  const bc_limb *limbs;
+  int len;
+  int frac;
+};
+
+//copies a magnitude into result, truncated or extended to scale digits, reusing the
+//capacity of result; the magnitude may be held by result itself. The sign is dropped
+//if the magnitude is zero
+static void bc_finish (const bc_mag &mag, int sign, int scale, bc_num &result) {
+  if (sign < 0 && bc_is_zero (mag.limbs, mag.len)) {
+    sign = 1;
+  }
+
+  //low limbs below the new scale are skipped, or zero limbs added below the magnitude
+  int new_frac = bc_frac_limbs (scale);
+  int skip = std::max (mag.frac - new_frac, 0);
+  int pad = std::max (new_frac - mag.frac, 0);
+  int len = bc_trim (mag.limbs, mag.len);
+  int n = std::max (len - skip, 0);
+
+  std::vector<bc_limb> &limbs = result.limbs;
+  if (mag.limbs == limbs.data()) {
+    if (pad > 0) {
+      limbs.resize (len + pad);
+      std::copy_backward (limbs.begin(), limbs.begin() + len, limbs.begin() + len + pad);
+    } else {
+      std::copy (limbs.begin() + skip, limbs.begin() + skip + n, limbs.begin());
+      limbs.resize (n);
+    }
+  } else {
+    limbs.resize (pad + n);
+    std::copy (mag.limbs + skip, mag.limbs + skip + n, limbs.begin() + pad);
+  }
+  std::fill (limbs.begin(), limbs.begin() + pad, 0);
+  if (limbs.size() < (size_t)new_frac) {
+    limbs.resize (new_frac, 0);
+  }
+  if (scale % BC_BASE_DIGITS != 0) {
+    limbs[0] -= limbs[0] % bc_pow10[BC_BASE_DIGITS - scale % BC_BASE_DIGITS];
+  }
+
+  result.sign = sign;
+  result.scale = scale;
+  bc_strip (result);
+}
+
+#ifdef BC_SIMD_X86
+//value of the 9 digits at s: the last 8 are turned into two 4 digit halves and then
+//into one number by multiply-adds of adjacent lanes
+__attribute__((target("sse4.1")))
+static bc_limb bc_read_limb_sse41 (const char *s) {
+  __m128i v = _mm_loadl_epi64 ((const __m128i *)(s + 1));
+  v = _mm_sub_epi8 (v, _mm_set1_epi8 ('0'));
+  v = _mm_maddubs_epi16 (v, _mm_setr_epi8 (10, 1, 10, 1, 10, 1, 10, 1, 0, 0, 0, 0, 0, 0, 0, 0));
+  v = _mm_madd_epi16 (v, _mm_setr_epi16 (100, 1, 100, 1, 0, 0, 0, 0));
+  v = _mm_packus_epi32 (v, v);
+  v = _mm_madd_epi16 (v, _mm_setr_epi16 (10000, 1, 0, 0, 0, 0, 0, 0));
+  return (bc_limb)(s[0] - '0') * 100000000 + (bc_limb)_mm_cvtsi128_si32 (v);
+}
+
+//index of the first non-digit in s[i, len), 16 characters per compare
+static int bc_scan_digits_sse2 (const char *s, int i, int len) {
+  const __m128i zero = _mm_set1_epi8 ('0'), nine = _mm_set1_epi8 (9);
+  for (; i + 16 <= len; i += 16) {
+    __m128i d = _mm_sub_epi8 (_mm_loadu_si128 ((const __m128i *)(s + i)), zero);
+    int mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_min_epu8 (d, nine), d));
+    if (mask != 0xFFFF) {
+      return i + __builtin_ctz (~mask);
+    }
+  }
+  return i;
+}
+#endif
+
+static bc_limb bc_read_limb (const char *s, int len) {
+#ifdef BC_SIMD_X86
+  if (len == BC_BASE_DIGITS && bc_has_sse41) {
+    return bc_read_limb_sse41 (s);
+  }
+#endif
+  bc_limb x = 0;
+  for (int i = 0; i < len; i++) {
+    x = x * 10 + (s[i] - '0');
+  }
+  return x;
+}
+
+//index of the first non-digit in s[i, len)
+static int bc_scan_digits (const char *s, int i, int len) {
+#ifdef BC_SIMD_X86
+  i = bc_scan_digits_sse2 (s, i, len);
+#endif
+  while (i < len && '0' <= s[i] && s[i] <= '9') {
+    i++;
+  }
+  return i;
+}
+
+static void bc_write_limb (char *s, bc_limb x, int len) {
+  for (int i = len - 1; i >= 0; i--) {
+    s[i] = (char)(x % 10 + '0');
+    x /= 10;
+  }
+}
+
+//parse a number into limbs, returns scale on success and -1 on error
+static int bc_parse_number (const char *s, int len, bc_num &num) {
+  int i = 0;
+  int lsign = 1;
+  if (i < len && (s[i] == '-' || s[i] == '+')) {
+    if (s[i] == '-') {
+      lsign = -1;
+    }
+    i++;
+  }
+  if (i >= len) {
+    return -1;
+  }
+  int lint = i;
+
+  i = bc_scan_digits (s, i, len);
+  int ldot = i;
+
+  int lscale = 0;
+  if (i < len && s[i] == '.') {
+    lscale = len - i - 1;
+    i++;
+  }
+  int lfrac = i;
+
+  i = bc_scan_digits (s, i, len);
+  if (i < len) {
+    return -1;
+  }
+
+  while (s[lint] == '0' && lint + 1 < ldot) {
+    lint++;
+  }
+
+  int llen = ldot - lint;
+  int frac = bc_frac_limbs (lscale);
+  num.limbs.assign (frac + (llen + BC_BASE_DIGITS - 1) / BC_BASE_DIGITS, 0);
+  for (int k = 0; k < frac; k++) {
+    int part = std::min (BC_BASE_DIGITS, lscale - k * BC_BASE_DIGITS);
+    num.limbs[frac - k - 1] = bc_read_limb (s + lfrac + k * BC_BASE_DIGITS, part) * bc_pow10[BC_BASE_DIGITS - part];
+  }
+  for (int k = 0; k * BC_BASE_DIGITS < llen; k++) {
+    int end = ldot - k * BC_BASE_DIGITS;
+    int part = std::min (BC_BASE_DIGITS, end - lint);
+    num.limbs[frac + k] = bc_read_limb (s + end - part, part);
+  }
+  num.sign = lsign;
+  num.scale = lscale;
+  bc_strip (num);
+
+  if (lsign < 0 && lscale == 0 && bc_is_zero (num)) {
+    num.sign = 1;
+  }
+  return lscale;
+}
+
+static int bc_parse_number (const BCMath::View &s, bc_num &num) {
+  if (s.size() > INT_MAX) {
+    return -1;
+  }
+  return bc_parse_number (s.data(), (int)s.size(), num);
+}
+
+//length of the text of num
+static int bc_string_length (const bc_num &num) {
+  return (num.sign < 0) + std::max (bc_int_digits (num), 1) + (num.scale > 0 ? num.scale + 1 : 0);
+}
+
+//writes the bc_string_length characters of num to s
+static void bc_write_number (char *s, const bc_num &num) {
+  int frac = bc_frac_limbs (num.scale);
+  int int_limbs = bc_int_limbs (num);
+  int int_len = std::max (bc_int_digits (num), 1);
+
+  if (num.sign < 0) {
+    *s++ = '-';
+  }
+  if (int_limbs > 0) {
+    int top = int_len - (int_limbs - 1) * BC_BASE_DIGITS;
+    bc_write_limb (s, num.limbs.back(), top);
+    s += top;
+    for (int i = (int)num.limbs.size() - 2; i >= frac; i--) {
+      bc_write_limb (s, num.limbs[i], BC_BASE_DIGITS);
+      s += BC_BASE_DIGITS;
+    }
+  } else {
+    *s++ = '0';
+  }
+
+  if (num.scale > 0) {
+    *s++ = '.';
+    for (int k = 0; k < frac; k++) {
+      int part = std::min (BC_BASE_DIGITS, num.scale - k * BC_BASE_DIGITS);
+      bc_write_limb (s, num.limbs[frac - k - 1] / bc_pow10[BC_BASE_DIGITS - part], part);
+      s += part;
+    }
+  }
+}
+
+static std::string bc_to_string (const bc_num &num) {
+  std::string result (bc_string_length (num), '0');
+  bc_write_number (&result[0], num);
+  return result;
+}
+
+//the text of num in out, which keeps its capacity
+static void bc_to_string (const bc_num &num, std::string &out) {
+  out.resize (bc_string_length (num));
+  bc_write_number (&out[0], num);
+}
+
+//reports an error according to the error policy of ctx
+static void bc_error (const BCMath::Context &ctx, const std::string &message) {
+  if (ctx.errors == BCMath::Context::THROW) {
+    throw std::runtime_error (message);
+  }
+  if (ctx.errors == BCMath::Context::REPORT) {
+    std::cerr << message << std::endl;
+  }
+}
+
+static std::string bc_zero (int scale) {
+  if (scale == 0) {
+    return ZERO;
+  }
+  std::string result (scale + 2, '0');
+  result[1] = '.';
+  return result;
+}
+
+#ifdef BC_SIMD_X86
+//carry into each of 8 lanes from the lanes that generate one (g) or pass one on (p)
+//and the carry into the first lane, resolved as a parallel prefix by one addition;
+//bit 8 of the result is the carry out of the last lane
+static inline unsigned bc_carry_lanes (unsigned g, unsigned p, unsigned carry) {
+  unsigned x = g | p;
+  return (x + g + carry) ^ x ^ g;
+}
+
+//-1 in the lanes whose bit is set in mask
+__attribute__((target("avx2")))
+static inline __m256i bc_lanes_avx2 (unsigned mask) {
+  const __m256i bits = _mm256_setr_epi32 (1, 2, 4, 8, 16, 32, 64, 128);
+  return _mm256_cmpeq_epi32 (_mm256_and_si256 (_mm256_set1_epi32 ((int)mask), bits), bits);
+}
+
+//r = a + b over n limbs, n a multiple of 8, returns carry
+__attribute__((target("avx2")))
+static bc_limb bc_add_n_avx2 (bc_limb *r, const bc_limb *a, const bc_limb *b, int n) {
+  const __m256i base = _mm256_set1_epi32 (BC_BASE), top = _mm256_set1_epi32 (BC_BASE - 1);
+  unsigned carry = 0;
+  for (int i = 0; i < n; i += 8) {
+    __m256i sum = _mm256_add_epi32 (_mm256_loadu_si256 ((const __m256i *)(a + i)), _mm256_loadu_si256 ((const __m256i *)(b + i)));
+    unsigned g = _mm256_movemask_ps (_mm256_castsi256_ps (_mm256_cmpgt_epi32 (sum, top)));
+    unsigned p = _mm256_movemask_ps (_mm256_castsi256_ps (_mm256_cmpeq_epi32 (sum, top)));
+    unsigned c = bc_carry_lanes (g, p, carry);
+    sum = _mm256_sub_epi32 (sum, bc_lanes_avx2 (c));
+    sum = _mm256_sub_epi32 (sum, _mm256_and_si256 (_mm256_cmpgt_epi32 (sum, top), base));
+    _mm256_storeu_si256 ((__m256i *)(r + i), sum);
+    carry = c >> 8;
+  }
+  return carry;
+}
+
+//r = a - b over n limbs, n a multiple of 8, returns borrow
+__attribute__((target("avx2")))
+static bc_limb bc_sub_n_avx2 (bc_limb *r, const bc_limb *a, const bc_limb *b, int n) {
+  const __m256i base = _mm256_set1_epi32 (BC_BASE), zero = _mm256_setzero_si256();
+  unsigned borrow = 0;
+  for (int i = 0; i < n; i += 8) {
+    __m256i diff = _mm256_sub_epi32 (_mm256_loadu_si256 ((const __m256i *)(a + i)), _mm256_loadu_si256 ((const __m256i *)(b + i)));
+    unsigned g = _mm256_movemask_ps (_mm256_castsi256_ps (diff));
+    unsigned p = _mm256_movemask_ps (_mm256_castsi256_ps (_mm256_cmpeq_epi32 (diff, zero)));
+    unsigned c = bc_carry_lanes (g, p, borrow);
+    diff = _mm256_add_epi32 (diff, bc_lanes_avx2 (c));
+    diff = _mm256_add_epi32 (diff, _mm256_and_si256 (_mm256_cmpgt_epi32 (zero, diff), base));
+    _mm256_storeu_si256 ((__m256i *)(r + i), diff);
+    borrow = c >> 8;
+  }
+  return borrow;
+}
+
+//index of the highest limb where a and b of n limbs differ, -1 if they are equal
+__attribute__((target("avx2")))
+static int bc_cmp_n_avx2 (const bc_limb *a, const bc_limb *b, int n) {
+  int i = n;
+  for (; i >= 8; i -= 8) {
+    __m256i eq = _mm256_cmpeq_epi32 (_mm256_loadu_si256 ((const __m256i *)(a + i - 8)), _mm256_loadu_si256 ((const __m256i *)(b + i - 8)));
+    unsigned ne = ~(unsigned)_mm256_movemask_ps (_mm256_castsi256_ps (eq)) & 0xFF;
+    if (ne != 0) {
+      return i - 8 + (31 - __builtin_clz (ne));
+    }
+  }
+  while (i > 0 && a[i - 1] == b[i - 1]) {
+    i--;
+  }
+  return i - 1;
+}
+#endif
+
+//compares a and b of n limbs each
+static int bc_cmp_n (const bc_limb *a, const bc_limb *b, int n) {
+  int i = n - 1;
+#ifdef BC_SIMD_X86
+  if (n >= 8 && bc_has_avx2) {
+    i = bc_cmp_n_avx2 (a, b, n);
+  }
+#endif
+  while (i >= 0 && a[i] == b[i]) {
+    i--;
+  }
+  if (i < 0) {
+    return 0;
+  }
+  return (a[i] < b[i] ? -1 : 1);
+}
+
+//r = a + b over n limbs, returns carry
+static bc_limb bc_add_n (bc_limb *r, const bc_limb *a, const bc_limb *b, int n) {
+  bc_limb carry = 0;
+  int i = 0;
+#ifdef BC_SIMD_X86
+  if (n >= 8 && bc_has_avx2) {
+    i = n & ~7;
+    carry = bc_add_n_avx2 (r, a, b, i);
+  }
+#endif
+  for (; i < n; i++) {
+    bc_limb um = a[i] + b[i] + carry;
+    carry = (um >= BC_BASE);
+    r[i] = carry ? um - BC_BASE : um;
+  }
+  return carry;
+}
+
+//r = a + carry over n limbs, returns carry
+static bc_limb bc_add_1 (bc_limb *r, const bc_limb *a, int n, bc_limb carry) {
+  int i = 0;
+  for (; i < n && carry; i++) {
+    carry = (a[i] == BC_BASE - 1);
+    r[i] = carry ? 0 : a[i] + 1;
+  }
+  if (r != a) {
+    memmove (r + i, a + i, sizeof (bc_limb) * (n - i));
+  }
+  return carry;
+}
+
+//r = a - b over n limbs, returns borrow
+static bc_limb bc_sub_n (bc_limb *r, const bc_limb *a, const bc_limb *b, int n) {
+  bc_limb borrow = 0;
+  int i = 0;
+#ifdef BC_SIMD_X86
+  if (n >= 8 && bc_has_avx2) {
+    i = n & ~7;
+    borrow = bc_sub_n_avx2 (r, a, b, i);
+  }
+#endif
+  for (; i < n; i++) {
+    bc_limb um = b[i] + borrow;
+    borrow = (a[i] < um);
+    r[i] = borrow ? a[i] + BC_BASE - um : a[i] - um;
+  }
+  return borrow;
+}
+
+//r = a - borrow over n limbs, returns borrow
+static bc_limb bc_sub_1 (bc_limb *r, const bc_limb *a, int n, bc_limb borrow) {
+  int i = 0;
+  for (; i < n && borrow; i++) {
+    borrow = (a[i] == 0);
+    r[i] = borrow ? BC_BASE - 1 : a[i] - 1;
+  }
+  if (r != a) {
+    memmove (r + i, a + i, sizeof (bc_limb) * (n - i));
+  }
+  return borrow;
+}
+
+//schoolbook products add each row into 64-bit columns without carrying; a column
+//holds a limb plus BC_MUL_DEFER products of (BASE - 1)^2 and a carry below 2^64, so
+//carries are propagated once every BC_MUL_DEFER rows
+static const int BC_MUL_DEFER = 18;
+
+#ifdef BC_SIMD_X86
+//cols[j] += x * b[j] for j < n, four products per instruction
+__attribute__((target("avx2")))
+static void bc_addmul_cols_avx2 (unsigned long long *cols, const bc_limb *b, int n, bc_limb x) {
+  const __m256i vx = _mm256_set1_epi64x (x);
+  int j = 0;
+  for (; j + 4 <= n; j += 4) {
+    __m256i vb = _mm256_cvtepu32_epi64 (_mm_loadu_si128 ((const __m128i *)(b + j)));
+    __m256i sum = _mm256_add_epi64 (_mm256_loadu_si256 ((const __m256i *)(cols + j)), _mm256_mul_epu32 (vb, vx));
+    _mm256_storeu_si256 ((__m256i *)(cols + j), sum);
+  }
+  for (; j < n; j++) {
+    cols[j] += (unsigned long long)x * b[j];
+  }
+}
+#endif
+
+//cols[j] += x * b[j] for j < n
+static void bc_addmul_cols (unsigned long long *cols, const bc_limb *b, int n, bc_limb x) {
+#ifdef BC_SIMD_X86
+  if (n >= 8 && bc_has_avx2) {
+    bc_addmul_cols_avx2 (cols, b, n, x);
+    return;
+  }
+#endif
+  for (int j = 0; j < n; j++) {
+    cols[j] += (unsigned long long)x * b[j];
+  }
+}
+
+//turns the columns [from, to) into limbs, their carry is added to cols[to]
+static void bc_carry_cols (unsigned long long *cols, int from, int to) {
+  unsigned long long carry = 0;
+  for (int k = from; k < to; k++) {
+    unsigned long long cur = cols[k] + carry;
+    cols[k] = cur % BC_BASE;
+    carry = cur / BC_BASE;
+  }
+  cols[to] += carry;
+}
+
+//r = the n columns, the last of which must already be below BASE after carrying
+static void bc_store_cols (bc_limb *r, unsigned long long *cols, int from, int n) {
+  bc_carry_cols (cols, from, n - 1);
+  BC_ASSERT (cols[n - 1] < BC_BASE);
+  for (int k = 0; k < n; k++) {
+    r[k] = (bc_limb)cols[k];
+  }
+}
+
+//r = a * b, r has alen + blen limbs and must not overlap the operands
+static void bc_mul_basecase (bc_limb *r, const bc_limb *a, int alen, const bc_limb *b, int blen) {
+  bc_scratch scratch;
+  unsigned long long *cols = scratch.zeros<unsigned long long> (alen + blen);
+
+  int from = 0;
+  for (int i = 0; i < alen; i++) {
+    if (a[i] != 0) {
+      bc_addmul_cols (cols + i, b, blen, a[i]);
+    }
+    if ((i + 1) % BC_MUL_DEFER == 0) {
+      bc_carry_cols (cols, from, i + blen);
+      from = i + 1;
+    }
+  }
+  bc_store_cols (r, cols, from, alen + blen);
+}
+
+//r = a + b for alen >= blen, r has alen + 1 limbs
+static void bc_add_limbs (bc_limb *r, const bc_limb *a, int alen, const bc_limb *b, int blen) {
+  bc_limb carry = bc_add_n (r, a, b, blen);
+  r[alen] = bc_add_1 (r + blen, a + blen, alen - blen, carry);
+}
+
+static void bc_mul_limbs (bc_limb *r, const bc_limb *a, int alen, const bc_limb *b, int blen);
+
+#ifdef __SIZEOF_INT128__
+//primes of the form c * 2^k + 1 with primitive root 3, transforms of up to 2^23 points
+//are possible modulo each of them and their product exceeds 2^22 * (BASE - 1)^2
+static const unsigned int BC_NTT_P1 = 998244353;
+static const unsigned int BC_NTT_P2 = 167772161;
+static const unsigned int BC_NTT_P3 = 469762049;
+static const int BC_NTT_MAX_LOG = 23;
+
+static unsigned int bc_pow_mod (unsigned long long a, unsigned long long e, unsigned int p) {
+  unsigned long long res = 1;
+  a %= p;
+  while (e > 0) {
+    if (e & 1) {
+      res = res * a % p;
+    }
+    a = a * a % p;
+    e >>= 1;
+  }
+  return (unsigned int)res;
+}
+
+//in-place number-theoretic transform of 2^log_n values modulo P
+template <unsigned int P>
+static void bc_ntt (unsigned int *a, int log_n, bool invert) {
+  int n = 1 << log_n;
+  for (int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap (a[i], a[j]);
+    }
+  }
+
+  bc_scratch scratch;
+  unsigned int *w = scratch.take<unsigned int> (n / 2);
+  for (int len = 2; len <= n; len <<= 1) {
+    int half = len / 2;
+    unsigned long long w_len = bc_pow_mod (3, (P - 1) / len, P);
+    if (invert) {
+      w_len = bc_pow_mod (w_len, P - 2, P);
+    }
+    w[0] = 1;
+    for (int j = 1; j < half; j++) {
+      w[j] = (unsigned int)(w[j - 1] * w_len % P);
+    }
+
+    for (int i = 0; i < n; i += len) {
+      unsigned int *x = a + i, *y = a + i + half;
+      for (int j = 0; j < half; j++) {
+        unsigned int u = x[j];
+        unsigned int v = (unsigned int)((unsigned long long)y[j] * w[j] % P);
+        x[j] = (u + v < P ? u + v : u + v - P);
+        y[j] = (u >= v ? u - v : u + P - v);
+      }
+    }
+  }
+
+  if (invert) {
+    unsigned long long n_inv = bc_pow_mod (n, P - 2, P);
+    for (int i = 0; i < n; i++) {
+      a[i] = (unsigned int)(a[i] * n_inv % P);
+    }
+  }
+}
+
+//cyclic convolution of a and b modulo P over 2^log_n points, stored into the
+//2^log_n values of res; a square (b == a) needs a single forward transform
+template <unsigned int P>
+static void bc_ntt_convolve (unsigned int *res, const bc_limb *a, int alen, const bc_limb *b, int blen, int log_n) {
+  int n = 1 << log_n;
+  memset (res, 0, sizeof (unsigned int) * n);
+  for (int i = 0; i < alen; i++) {
+    res[i] = a[i] % P;
+  }
+  bc_ntt<P> (res, log_n, false);
+
+  if (b == a && blen == alen) {
+    for (int i = 0; i < n; i++) {
+      res[i] = (unsigned int)((unsigned long long)res[i] * res[i] % P);
+    }
+  } else {
+    bc_scratch scratch;
+    unsigned int *fb = scratch.zeros<unsigned int> (n);
+    for (int i = 0; i < blen; i++) {
+      fb[i] = b[i] % P;
+    }
+    bc_ntt<P> (fb, log_n, false);
+    for (int i = 0; i < n; i++) {
+      res[i] = (unsigned int)((unsigned long long)res[i] * fb[i] % P);
+    }
+  }
+  bc_ntt<P> (res, log_n, true);
+}
+
+//r = a * b through convolutions modulo three primes glued together by the
+//chinese remainder theorem, alen + blen must not exceed 2^BC_NTT_MAX_LOG
+static void bc_mul_ntt (bc_limb *r, const bc_limb *a, int alen, const bc_limb *b, int blen) {
+  int log_n = 0;
+  while ((1 << log_n) < alen + blen - 1) {
+    log_n++;
+  }
+
+  bc_scratch scratch;
+  unsigned int *f1 = scratch.take<unsigned int> (1 << log_n);
+  unsigned int *f2 = scratch.take<unsigned int> (1 << log_n);
+  unsigned int *f3 = scratch.take<unsigned int> (1 << log_n);
+  bc_ntt_convolve<BC_NTT_P1> (f1, a, alen, b, blen, log_n);
+  bc_ntt_convolve<BC_NTT_P2> (f2, a, alen, b, blen, log_n);
+  bc_ntt_convolve<BC_NTT_P3> (f3, a, alen, b, blen, log_n);
+
+  const unsigned long long p12 = (unsigned long long)BC_NTT_P1 * BC_NTT_P2;
+  const unsigned long long inv1 = bc_pow_mod (BC_NTT_P1, BC_NTT_P2 - 2, BC_NTT_P2);
+  const unsigned long long inv12 = bc_pow_mod (p12 % BC_NTT_P3, BC_NTT_P3 - 2, BC_NTT_P3);
+
+  unsigned __int128 carry = 0;
+  for (int i = 0; i < alen + blen - 1; i++) {
+    unsigned long long x1 = f1[i];
+    unsigned long long k2 = (f2[i] + BC_NTT_P2 - x1 % BC_NTT_P2) % BC_NTT_P2 * inv1 % BC_NTT_P2;
+    unsigned long long x12 = x1 + BC_NTT_P1 * k2;
+    unsigned long long k3 = (f3[i] + BC_NTT_P3 - x12 % BC_NTT_P3) % BC_NTT_P3 * inv12 % BC_NTT_P3;
+    carry += x12 + (unsigned __int128)p12 * k3;
+    r[i] = (bc_limb)(carry % BC_BASE);
+    carry /= BC_BASE;
+  }
+  BC_ASSERT (carry < BC_BASE);
+  r[alen + blen - 1] = (bc_limb)carry;
+}
+#endif
+
+//r = a * b for alen / 2 < blen <= alen, splitting both operands at alen / 2 limbs:
+//a * b = z2 * BASE^2m + ((a0 + a1) * (b0 + b1) - z0 - z2) * BASE^m + z0
+static void bc_mul_karatsuba (bc_limb *r, const bc_limb *a, int alen, const bc_limb *b, int blen) {
+  int m = alen / 2;
+  const bc_limb *a0 = a, *a1 = a + m, *b0 = b, *b1 = b + m;
+  int a1len = alen - m, b1len = blen - m;
+
+  bc_mul_limbs (r, a0, m, b0, m);
+  bc_mul_limbs (r + 2 * m, a1, a1len, b1, b1len);
+
+  int salen = a1len + 1;
+  int sblen = std::max (m, b1len) + 1;
+  int zlen = salen + sblen;
+  bc_scratch scratch;
+  bc_limb *sa = scratch.take<bc_limb> (salen + sblen + zlen), *sb = sa + salen, *z1 = sb + sblen;
+
+  bc_add_limbs (sa, a1, a1len, a0, m);
+  if (b1len >= m) {
+    bc_add_limbs (sb, b1, b1len, b0, m);
+  } else {
+    bc_add_limbs (sb, b0, m, b1, b1len);
+  }
+  bc_mul_limbs (z1, sa, salen, sb, sblen);
+
+  bc_limb borrow = bc_sub_n (z1, z1, r, 2 * m);
+  bc_sub_1 (z1 + 2 * m, z1 + 2 * m, zlen - 2 * m, borrow);
+  borrow = bc_sub_n (z1, z1, r + 2 * m, alen + blen - 2 * m);
+  bc_sub_1 (z1 + alen + blen - 2 * m, z1 + alen + blen - 2 * m, zlen - (alen + blen - 2 * m), borrow);
+
+  while (zlen > 0 && z1[zlen - 1] == 0) {
+    zlen--;
+  }
+  bc_limb carry = bc_add_n (r + m, r + m, z1, zlen);
+  carry = bc_add_1 (r + m + zlen, r + m + zlen, alen + blen - m - zlen, carry);
+  BC_ASSERT (carry == 0);
+}
+
+//r = a * b, r has alen + blen limbs and must not overlap the operands
+static void bc_mul_limbs (bc_limb *r, const bc_limb *a, int alen, const bc_limb *b, int blen) {
+  if (alen < blen) {
+    std::swap (a, b);
+    std::swap (alen, blen);
+  }
+
+  if (blen < BC_KARATSUBA_THRESHOLD) {
+    bc_mul_basecase (r, a, alen, b, blen);
+    return;
+  }
+
+#ifdef __SIZEOF_INT128__
+  if (blen >= BC_NTT_THRESHOLD && alen + blen <= (1 << BC_NTT_MAX_LOG)) {
+    bc_mul_ntt (r, a, alen, b, blen);
+    return;
+  }
+#endif
+
+  if (2 * blen <= alen) {
+    memset (r, 0, sizeof (bc_limb) * (alen + blen));
+    bc_scratch scratch;
+    bc_limb *tmp = scratch.take<bc_limb> (2 * blen);
+    for (int i = 0; i < alen; i += blen) {
+      int len = std::min (blen, alen - i);
+      bc_mul_limbs (tmp, a + i, len, b, blen);
+      bc_limb carry = bc_add_n (r + i, r + i, tmp, len + blen);
+      bc_add_1 (r + i + len + blen, r + i + len + blen, alen - i - len, carry);
+    }
+    return;
+  }
+
+  bc_mul_karatsuba (r, a, alen, b, blen);
+}
+
+//r = a * a, r has 2n limbs and must not overlap a; every cross product a[i] * a[j]
+//with i < j is computed once and doubled, then the squares a[i] * a[i] are added
+static void bc_sqr_basecase (bc_limb *r, const bc_limb *a, int n) {
+  bc_scratch scratch;
+  unsigned long long *cols = scratch.zeros<unsigned long long> (2 * n);
+
+  int from = 0;
+  for (int i = 0; i < n - 1; i++) {
+    if (a[i] != 0) {
+      bc_addmul_cols (cols + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    if ((i + 1) % BC_MUL_DEFER == 0) {
+      bc_carry_cols (cols, from, i + n);
+      from = 2 * i + 3;
+    }
+  }
+  bc_carry_cols (cols, from, 2 * n - 1);
+
+  for (int k = 0; k < 2 * n; k++) {
+    cols[k] *= 2;
+  }
+  for (int i = 0; i < n; i++) {
+    cols[2 * i] += (unsigned long long)a[i] * a[i];
+  }
+  bc_store_cols (r, cols, 0, 2 * n);
+}
+
+static void bc_sqr_limbs (bc_limb *r, const bc_limb *a, int n);
+
+//r = a * a splitting a at n / 2 limbs:
+//a * a = z2 * BASE^2m + ((a0 + a1)^2 - z0 - z2) * BASE^m + z0
+static void bc_sqr_karatsuba (bc_limb *r, const bc_limb *a, int n) {
+  int m = n / 2;
+  const bc_limb *a0 = a, *a1 = a + m;
+  int a1len = n - m;
+
+  bc_sqr_limbs (r, a0, m);
+  bc_sqr_limbs (r + 2 * m, a1, a1len);
+
+  int slen = a1len + 1;
+  int zlen = 2 * slen;
+  bc_scratch scratch;
+  bc_limb *sa = scratch.take<bc_limb> (slen + zlen), *z1 = sa + slen;
+
+  bc_add_limbs (sa, a1, a1len, a0, m);
+  bc_sqr_limbs (z1, sa, slen);
+
+  bc_limb borrow = bc_sub_n (z1, z1, r, 2 * m);
+  bc_sub_1 (z1 + 2 * m, z1 + 2 * m, zlen - 2 * m, borrow);
+  borrow = bc_sub_n (z1, z1, r + 2 * m, 2 * a1len);
+  bc_sub_1 (z1 + 2 * a1len, z1 + 2 * a1len, zlen - 2 * a1len, borrow);
+
+  while (zlen > 0 && z1[zlen - 1] == 0) {
+    zlen--;
+  }
+  bc_limb carry = bc_add_n (r + m, r + m, z1, zlen);
+  carry = bc_add_1 (r + m + zlen, r + m + zlen, 2 * n - m - zlen, carry);
+  BC_ASSERT (carry == 0);
+}
+
+//r = a * a, r has 2n limbs and must not overlap a
+static void bc_sqr_limbs (bc_limb *r, const bc_limb *a, int n) {
+  if (n < BC_SQR_KARATSUBA_THRESHOLD) {
+    bc_sqr_basecase (r, a, n);
+    return;
+  }
+
+#ifdef __SIZEOF_INT128__
+  if (n >= BC_NTT_THRESHOLD && 2 * n <= (1 << BC_NTT_MAX_LOG)) {
+    bc_mul_ntt (r, a, n, a, n);
+    return;
+  }
+#endif
+
+  bc_sqr_karatsuba (r, a, n);
+}
+
+//r = a * x over n limbs, returns carry
+static bc_limb bc_mul_1 (bc_limb *r, const bc_limb *a, int n, bc_limb x) {
+  unsigned long long carry = 0;
+  for (int i = 0; i < n; i++) {
+    unsigned long long cur = (unsigned long long)a[i] * x + carry;
+    r[i] = (bc_limb)(cur % BC_BASE);
+    carry = cur / BC_BASE;
+  }
+  return (bc_limb)carry;
+}
+
+//floor((2^64 - 1) / d), lets bc_div_pre replace a hardware division by a multiplication
+static unsigned long long bc_invert (unsigned long long d) {
+  return ~0ULL / d;
+}
+
+//floor(x / d) for x < BASE * d < 2^63, inv = bc_invert (d)
+static inline unsigned long long bc_div_pre (unsigned long long x, unsigned long long d, unsigned long long inv) {
+#ifdef __SIZEOF_INT128__
+  //the estimate is at most one below the quotient
+  unsigned long long q = (unsigned long long)(((unsigned __int128)x * inv) >> 64);
+  if (x - q * d >= d) {
+    q++;
+  }
+  return q;
+#else
+  (void)inv;
+  return x / d;
+#endif
+}
+
+//q = u / v over ulen limbs with inv = bc_invert (v), returns remainder
+static bc_limb bc_div_1_pre (bc_limb *q, const bc_limb *u, int ulen, bc_limb v, unsigned long long inv) {
+  unsigned long long rem = 0;
+  for (int i = ulen - 1; i >= 0; i--) {
+    unsigned long long cur = rem * BC_BASE + u[i];
+    unsigned long long qi = bc_div_pre (cur, v, inv);
+    q[i] = (bc_limb)qi;
+    rem = cur - qi * v;
+  }
+  return (bc_limb)rem;
+}
+
+//q = u / v over ulen limbs, returns remainder
+static bc_limb bc_div_1 (bc_limb *q, const bc_limb *u, int ulen, bc_limb v) {
+  return bc_div_1_pre (q, u, ulen, v, bc_invert (v));
+}
+
+#ifdef __SIZEOF_INT128__
+//q = u / v for BASE <= v < BASE^2 (a divisor of two limbs), q has ulen - 1 limbs, returns remainder
+static unsigned long long bc_div_2 (bc_limb *q, const bc_limb *u, int ulen, unsigned long long v) {
+  unsigned long long rem = u[ulen - 1];
+  for (int i = ulen - 2; i >= 0; i--) {
+    unsigned __int128 cur = (unsigned __int128)rem * BC_BASE + u[i];
+    unsigned long long qi = (unsigned long long)(cur / v);
+    q[i] = (bc_limb)qi;
+    rem = (unsigned long long)(cur - (unsigned __int128)qi * v);
+  }
+  return rem;
+}
+#endif
+
+//q = un / vn, where vn is normalised so that its top limb is at least BASE / 2,
+//un has ulen + 1 limbs and is overwritten by the remainder, inv = bc_invert (vn[vlen - 1])
+static void bc_div_knuth_pre (bc_limb *q, bc_limb *un, int ulen, const bc_limb *vn, int vlen, unsigned long long inv) {
+  unsigned long long vtop = vn[vlen - 1], vnext = vn[vlen - 2];
+  for (int j = ulen - vlen; j >= 0; j--) {
+    bc_limb *uj = un + j;
+    unsigned long long num = (unsigned long long)uj[vlen] * BC_BASE + uj[vlen - 1];
+    unsigned long long qhat = bc_div_pre (num, vtop, inv), rhat = num - qhat * vtop;
+    while (qhat >= BC_BASE || qhat * vnext > rhat * BC_BASE + uj[vlen - 2]) {
+      qhat--;
+      rhat += vtop;
+      if (rhat >= BC_BASE) {
+        break;
+      }
+    }
+
+    unsigned long long carry = 0;
+    bc_limb borrow = 0;
+    for (int i = 0; i < vlen; i++) {
+      unsigned long long p = qhat * vn[i] + carry;
+      carry = p / BC_BASE;
+      bc_limb sub = (bc_limb)(p % BC_BASE) + borrow;
+      borrow = (uj[i] < sub);
+      uj[i] = borrow ? uj[i] + BC_BASE - sub : uj[i] - sub;
+    }
+    bc_limb sub = (bc_limb)carry + borrow;
+    if (uj[vlen] < sub) {
+      qhat--;
+      uj[vlen] += bc_add_n (uj, uj, vn, vlen) - sub;
+    } else {
+      uj[vlen] -= sub;
+    }
+    q[j] = (bc_limb)qhat;
+  }
+}
+
+//q = u / v for vlen >= 2 and v[vlen - 1] != 0, q has ulen - vlen + 1 limbs
+//(Knuth, TAOCP vol. 2, 4.3.1, algorithm D)
+static void bc_div_knuth (bc_limb *q, const bc_limb *u, int ulen, const bc_limb *v, int vlen) {
+  bc_scratch scratch;
+  bc_limb *un = scratch.take<bc_limb> (ulen + 1), *vn = scratch.take<bc_limb> (vlen);
+
+  //scale both operands so that the top divisor limb is at least BASE / 2,
+  //then every estimated quotient limb is at most two above the real one
+  bc_limb d = BC_BASE / (v[vlen - 1] + 1);
+  bc_mul_1 (vn, v, vlen, d);
+  un[ulen] = bc_mul_1 (un, u, ulen, d);
+  bc_div_knuth_pre (q, un, ulen, vn, vlen, bc_invert (vn[vlen - 1]));
+}
+
+static int bc_cmp_limbs (const bc_limb *a, int alen, const bc_limb *b, int blen) {
+  alen = bc_trim (a, alen);
+  blen = bc_trim (b, blen);
+  if (alen != blen) {
+    return (alen < blen ? -1 : 1);
+  }
+  return bc_cmp_n (a, b, alen);
+}
+
+//a -= b for a >= b, returns the new length of a
+static int bc_sub_limbs (bc_limb *a, int alen, const bc_limb *b, int blen) {
+  blen = bc_trim (b, blen);
+  bc_limb borrow = bc_sub_n (a, a, b, blen);
+  borrow = bc_sub_1 (a + blen, a + blen, alen - blen, borrow);
+  BC_ASSERT (borrow == 0);
+  return bc_trim (a, alen);
+}
+
+//x ~ BASE^2p / v for the p limbs of v, v[p - 1] != 0, into the p + 3 limbs of x, returns
+//the length of x; x is refined from the reciprocal of the top half of v by one Newton
+//step x += x * (BASE^2p - v * x) / BASE^2p
+static int bc_recip (bc_limb *x, const bc_limb *v, int p) {
+  bc_scratch scratch;
+  memset (x, 0, sizeof (bc_limb) * (p + 3));
+  if (p <= BC_NEWTON_BASECASE) {
+    bc_limb *u = scratch.zeros<bc_limb> (2 * p + 1);
+    u[2 * p] = 1;
+    if (p == 1) {
+      bc_div_1 (x, u, 2 * p + 1, v[0]);
+    } else {
+      bc_div_knuth (x, u, 2 * p + 1, v, p);
+    }
+    return bc_trim (x, p + 2);
+  }
+
+  int h = p / 2 + 1;
+  bc_limb *xh = scratch.take<bc_limb> (h + 3);
+  int xhlen = bc_recip (xh, v + (p - h), h);
+
+  int xlen = (p - h) + xhlen;
+  memcpy (x + (p - h), xh, sizeof (bc_limb) * xhlen);
+
+  int esize = std::max (p + xlen, 2 * p + 1), osize = 2 * p + 1;
+  bc_limb *e = scratch.zeros<bc_limb> (esize);
+  bc_mul_limbs (e, v, p, x, xlen);
+  bc_limb *one = scratch.zeros<bc_limb> (osize);
+  one[2 * p] = 1;
+
+  bool over = (bc_cmp_limbs (e, esize, one, osize) > 0);
+  if (!over) {
+    std::swap (e, one);
+    std::swap (esize, osize);
+  }
+  int elen = bc_sub_limbs (e, esize, one, osize);
+  if (elen == 0) {
+    return bc_trim (x, xlen + 1);
+  }
+
+  bc_limb *corr = scratch.take<bc_limb> (xlen + elen);
+  bc_mul_limbs (corr, x, xlen, e, elen);
+  int clen = bc_trim (corr, xlen + elen) - 2 * p;
+  if (clen <= 0) {
+    return bc_trim (x, xlen + 1);
+  }
+  if (over) {
+    bc_sub_limbs (x, xlen + 1, corr + 2 * p, clen);
+  } else {
+    bc_limb carry = bc_add_n (x, x, corr + 2 * p, clen);
+    bc_add_1 (x + clen, x + clen, xlen + 1 - clen, carry);
+  }
+  return bc_trim (x, xlen + 1);
+}
+
+//q = u / v for v[vlen - 1] != 0, q has ulen - vlen + 1 limbs; the quotient is
+//estimated with a Newton reciprocal of the top limbs of v and then corrected
+//against the exact remainder
+static void bc_div_newton (bc_limb *q, const bc_limb *u, int ulen, const bc_limb *v, int vlen) {
+  int n = ulen - vlen + 1;
+  int p = n + 1;
+  bc_scratch scratch;
+
+  //the reciprocal needs p limbs of precision: the divisor is truncated to its
+  //top p limbs when longer, and padded with zero limbs when shorter
+  bc_limb *x = scratch.take<bc_limb> (p + 3);
+  int drop = vlen - p, shift = 2 * p, xlen;
+  if (drop >= 0) {
+    xlen = bc_recip (x, v + drop, p);
+  } else {
+    bc_limb *vp = scratch.zeros<bc_limb> (p);
+    memcpy (vp - drop, v, sizeof (bc_limb) * vlen);
+    xlen = bc_recip (x, vp, p);
+    shift += drop;
+    drop = 0;
+  }
+
+  int plen = ulen - drop + xlen;
+  bc_limb *prod = scratch.take<bc_limb> (plen);
+  bc_mul_limbs (prod, u + drop, ulen - drop, x, xlen);
+  bc_limb *qt = scratch.zeros<bc_limb> (n + 2);
+  int qlen = std::min (n + 2, bc_trim (prod, plen) - shift);
+  if (qlen > 0) {
+    memcpy (qt, prod + shift, sizeof (bc_limb) * qlen);
+  }
+  qlen = bc_trim (qt, n + 2);
+
+  bc_limb *r = scratch.zeros<bc_limb> (std::max (qlen + vlen, ulen));
+  int rlen = 0;
+  if (qlen > 0) {
+    bc_mul_limbs (r, qt, qlen, v, vlen);
+    rlen = bc_trim (r, qlen + vlen);
+  }
+
+  if (bc_cmp_limbs (r, rlen, u, ulen) > 0) {
+    while (bc_cmp_limbs (r, rlen, u, ulen) > 0) {
+      rlen = bc_sub_limbs (r, rlen, v, vlen);
+      bc_sub_1 (qt, qt, n + 2, 1);
+    }
+  } else {
+    bc_limb *t = scratch.take<bc_limb> (ulen);
+    memcpy (t, u, sizeof (bc_limb) * ulen);
+    rlen = bc_sub_limbs (t, ulen, r, rlen);
+    while (bc_cmp_limbs (t, rlen, v, vlen) >= 0) {
+      rlen = bc_sub_limbs (t, rlen, v, vlen);
+      bc_add_1 (qt, qt, n + 2, 1);
+    }
+  }
+
+  BC_ASSERT (qt[n] == 0 && qt[n + 1] == 0);
+  memcpy (q, qt, sizeof (bc_limb) * n);
+}
+
+//q = u / v for vlen >= 2, v[0] != 0 and v[vlen - 1] != 0, q has ulen - vlen + 1 limbs;
+//u is reduced by blocks of vlen limbs using m = floor(BASE^2vlen / v) of vlen + 1 limbs
+//(Barrett reduction, HAC 14.42), each block costs two multiplications and at most two subtractions
+static void bc_div_barrett (bc_limb *q, const bc_limb *u, int ulen, const bc_limb *v, int vlen, const bc_limb *m) {
+  int n = vlen, blocks = (ulen + n - 1) / n;
+  bc_scratch scratch;
+  bc_limb *qt = scratch.take<bc_limb> (blocks * n), *t = scratch.take<bc_limb> (2 * n);
+  bc_limb *prod = scratch.take<bc_limb> (2 * n + 2), *qv = scratch.take<bc_limb> (2 * n + 1);
+  bc_limb *rem = scratch.zeros<bc_limb> (n);
+
+  for (int b = blocks - 1; b >= 0; b--) {
+    //t = rem * BASE^n + next block of u, t < v * BASE^n
+    int lo = b * n, len = std::min (n, ulen - lo);
+    memset (t, 0, sizeof (bc_limb) * 2 * n);
+    memcpy (t, u + lo, sizeof (bc_limb) * len);
+    memcpy (t + n, rem, sizeof (bc_limb) * n);
+
+    //qb = floor (floor (t / BASE^(n - 1)) * m / BASE^(n + 1)) is at most two below t / v
+    bc_mul_limbs (prod, t + n - 1, n + 1, m, n + 1);
+    bc_limb *qb = prod + n + 1;
+    int qlen = bc_trim (qb, n + 1);
+    if (qlen > 0) {
+      bc_mul_limbs (qv, qb, qlen, v, n);
+      bc_sub_limbs (t, 2 * n, qv, qlen + n);
+    }
+    while (bc_cmp_limbs (t, 2 * n, v, n) >= 0) {
+      bc_sub_limbs (t, 2 * n, v, n);
+      bc_add_1 (qb, qb, n + 1, 1);
+    }
+
+    BC_ASSERT (qb[n] == 0);
+    memcpy (qt + lo, qb, sizeof (bc_limb) * n);
+    memcpy (rem, t, sizeof (bc_limb) * n);
+  }
+  memcpy (q, qt, sizeof (bc_limb) * (ulen - vlen + 1));
+}
+
+//compares magnitudes, looking at no more than scale digits of the fractional parts
+static int bc_comp (const bc_num &lhs, const bc_num &rhs, int scale) {
+  int llen = bc_int_limbs (lhs);
+  int rlen = bc_int_limbs (rhs);
+
+  if (llen != rlen) {
+    return (llen < rlen ? -1 : 1);
+  }
+
+  int lfrac = bc_frac_limbs (lhs.scale);
+  int rfrac = bc_frac_limbs (rhs.scale);
+  int res = bc_cmp_n (lhs.limbs.data() + lfrac, rhs.limbs.data() + rfrac, llen);
+  if (res != 0) {
+    return res;
+  }
+
+  //whole fractional limbs present in both numbers, then the rest one by one
+  int common = std::min (std::min (lfrac, rfrac), scale / BC_BASE_DIGITS);
+  res = bc_cmp_n (lhs.limbs.data() + lfrac - common, rhs.limbs.data() + rfrac - common, common);
+  if (res != 0) {
+    return res;
+  }
+
+  for (int k = common; (k < lfrac || k < rfrac) && k * BC_BASE_DIGITS < scale; k++) {
+    bc_limb x = (k < lfrac ? lhs.limbs[lfrac - k - 1] : 0);
+    bc_limb y = (k < rfrac ? rhs.limbs[rfrac - k - 1] : 0);
+    if (scale - k * BC_BASE_DIGITS < BC_BASE_DIGITS) {
+      x /= bc_pow10[BC_BASE_DIGITS - (scale - k * BC_BASE_DIGITS)];
+      y /= bc_pow10[BC_BASE_DIGITS - (scale - k * BC_BASE_DIGITS)];
+    }
+    if (x != y) {
+      return (x < y ? -1 : 1);
+    }
+  }
+
+  return 0;
+}
+
+//|lhs| + |rhs| in scratch memory
+static bc_mag bc_add_positive (const bc_num &lhs, const bc_num &rhs, bc_scratch &scratch) {
+  int lfrac = bc_frac_limbs (lhs.scale);
+  int rfrac = bc_frac_limbs (rhs.scale);
+  int frac = std::max (lfrac, rfrac);
+  int result_len = std::max (bc_int_limbs (lhs), bc_int_limbs (rhs)) + frac + 1;
+
+  bc_limb *res = scratch.zeros<bc_limb> (result_len);
+  std::copy (lhs.limbs.begin(), lhs.limbs.end(), res + frac - lfrac);
+
+  int off = frac - rfrac;
+  int rlen = (int)rhs.limbs.size();
+  bc_limb carry = bc_add_n (res + off, res + off, rhs.limbs.data(), rlen);
+  bc_add_1 (res + off + rlen, res + off + rlen, result_len - off - rlen, carry);
+  bc_mag mag = { res, result_len, frac };
+  return mag;
+}
+
+//|lhs| - |rhs| for |lhs| >= |rhs| in scratch memory
+static bc_mag bc_sub_positive (const bc_num &lhs, const bc_num &rhs, bc_scratch &scratch) {
+  int lfrac = bc_frac_limbs (lhs.scale);
+  int rfrac = bc_frac_limbs (rhs.scale);
+  int frac = std::max (lfrac, rfrac);
+  int result_len = bc_int_limbs (lhs) + frac;
+
+  bc_limb *res = scratch.zeros<bc_limb> (result_len);
+  std::copy (lhs.limbs.begin(), lhs.limbs.end(), res + frac - lfrac);
+
+  int off = frac - rfrac;
+  int rlen = (int)rhs.limbs.size();
+  bc_limb borrow = bc_sub_n (res + off, res + off, rhs.limbs.data(), rlen);
+  borrow = bc_sub_1 (res + off + rlen, res + off + rlen, result_len - off - rlen, borrow);
+  BC_ASSERT (borrow == 0);
+  bc_mag mag = { res, result_len, frac };
+  return mag;
+}
+
+//r = the columns of a * b from column c up, r has alen + blen - c limbs; the
+//columns below c are skipped, so r * BASE^c falls short of a * b by less than BASE^(c + 2)
+static void bc_mul_short (bc_limb *r, const bc_limb *a, int alen, const bc_limb *b, int blen, int c) {
+  int rlen = alen + blen - c;
+
+  //operand limbs that only reach columns below c are dropped
+  int da = std::max (0, c - (blen - 1));
+  a += da;
+  alen -= da;
+  c -= da;
+  int db = std::max (0, c - (alen - 1));
+  b += db;
+  blen -= db;
+  c -= db;
+  if (alen <= 0 || blen <= 0) {
+    memset (r, 0, sizeof (bc_limb) * rlen);
+    return;
+  }
+
+  bc_scratch scratch;
+  if (std::min (alen, blen) >= BC_KARATSUBA_THRESHOLD) {
+    bc_limb *tmp = scratch.take<bc_limb> (alen + blen);
+    bc_mul_limbs (tmp, a, alen, b, blen);
+    memcpy (r, tmp + c, sizeof (bc_limb) * rlen);
+    return;
+  }
+
+  unsigned long long *cols = scratch.zeros<unsigned long long> (rlen);
+
+  int from = 0;
+  for (int i = 0; i < alen; i++) {
+    int j = std::max (0, c - i);
+    if (a[i] != 0) {
+      bc_addmul_cols (cols + i + j - c, b + j, blen - j, a[i]);
+    }
+    if ((i + 1) % BC_MUL_DEFER == 0) {
+      bc_carry_cols (cols, from, i + blen - c);
+      from = std::max (0, i + 1 - c);
+    }
+  }
+  bc_store_cols (r, cols, from, rlen);
+}
+
+//|lhs| * |rhs| in scratch memory, with at least enough low limbs for scale digits
+static bc_mag bc_mul_positive (const bc_num &lhs, const bc_num &rhs, int scale, bc_scratch &scratch) {
+  int llen = (int)lhs.limbs.size();
+  int rlen = (int)rhs.limbs.size();
+  int frac = bc_frac_limbs (lhs.scale) + bc_frac_limbs (rhs.scale);
+
+  //limbs below target are truncated away, columns below c are not computed at all;
+  //a carry out of them can only reach target when limb target - 1 is BASE - 1
+  int target = frac - bc_frac_limbs (scale);
+  int c = target - BC_MUL_GUARD;
+  if (c > 0 && llen > 0 && rlen > 0) {
+    bc_limb *res = scratch.take<bc_limb> (llen + rlen - c);
+    bc_mul_short (res, lhs.limbs.data(), llen, rhs.limbs.data(), rlen, c);
+    bool exact = false;
+    for (int i = target - c - 1; i >= 2 && !exact; i--) {
+      exact = (res[i] != BC_BASE - 1);
+    }
+    if (exact) {
+      bc_mag mag = { res, llen + rlen - c, frac - c };
+      return mag;
+    }
+  }
+
+  bc_limb *res = scratch.zeros<bc_limb> (llen + rlen);
+  if (&lhs == &rhs) {
+    //a square, as in bcpow, needs about half the limb products
+    if (llen > 0) {
+      bc_sqr_limbs (res, lhs.limbs.data(), llen);
+    }
+  } else if (llen > 0 && rlen > 0) {
+    bc_mul_limbs (res, lhs.limbs.data(), llen, rhs.limbs.data(), rlen);
+  }
+  bc_mag mag = { res, llen + rlen, frac };
+  return mag;
+}
+
+//q = u / v for ulen >= vlen and v[vlen - 1] != 0, q has ulen - vlen + 1 limbs
+static void bc_div_limbs (bc_limb *q, const bc_limb *u, int ulen, const bc_limb *v, int vlen) {
+  if (vlen == 1) {
+    bc_div_1 (q, u, ulen, v[0]);
+#ifdef __SIZEOF_INT128__
+  } else if (vlen == 2) {
+    bc_div_2 (q, u, ulen, (unsigned long long)v[1] * BC_BASE + v[0]);
+#endif
+  } else if (vlen >= BC_NEWTON_THRESHOLD && ulen - vlen >= BC_NEWTON_THRESHOLD) {
+    bc_div_newton (q, u, ulen, v, vlen);
+  } else {
+    bc_div_knuth (q, u, ulen, v, vlen);
+  }
+}
+
+//u = |lhs| * BASE^shift lined up against a divisor with rfrac fractional limbs, low of
+//which are zero and dropped, so that the quotient has frac fractional limbs; u is taken
+//from scratch with a spare limb on top, returns its length without leading zero limbs
+static int bc_div_dividend (const bc_num &lhs, int frac, int rfrac, int low, bc_scratch &scratch, bc_limb *&u) {
+  int shift = frac + rfrac - low - bc_frac_limbs (lhs.scale);
+  int lsize = (int)lhs.limbs.size();
+  int len = std::max (lsize + shift, 0);
+  u = scratch.take<bc_limb> (len + 1);
+  if (shift >= 0) {
+    memset (u, 0, sizeof (bc_limb) * shift);
+    std::copy (lhs.limbs.begin(), lhs.limbs.end(), u + shift);
+  } else if (len > 0) {
+    std::copy (lhs.limbs.begin() + (-shift), lhs.limbs.end(), u);
+  }
+  return bc_trim (u, len);
+}
+
+//|lhs| / |rhs| truncated to scale digits in scratch memory
+static bc_mag bc_div_positive (const bc_num &lhs, const bc_num &rhs, int scale, bc_scratch &scratch) {
+  int frac = bc_frac_limbs (scale);
+
+  const bc_limb *v = rhs.limbs.data();
+  int vlen = bc_trim (v, (int)rhs.limbs.size());
+  BC_ASSERT (vlen > 0);
+  int low = 0;
+  while (v[low] == 0) {
+    low++;
+  }
+  v += low;
+  vlen -= low;
+
+  bc_limb *u;
+  int ulen = bc_div_dividend (lhs, frac, bc_frac_limbs (rhs.scale), low, scratch, u);
+  int qlen = std::max (ulen - vlen + 1, frac);
+  bc_limb *q = scratch.zeros<bc_limb> (qlen);
+  if (ulen >= vlen) {
+    bc_div_limbs (q, u, ulen, v, vlen);
+  }
+  bc_mag mag = { q, qlen, frac };
+  return mag;
+}
+
+static void bc_add (const bc_num &lhs, int lsign, const bc_num &rhs, int rsign, int scale, bc_num &result) {
+  bc_scratch scratch;
+  bc_mag res;
+  int sign;
+  if (lsign == rsign) {
+    res = bc_add_positive (lhs, rhs, scratch);
+    sign = lsign;
+  } else if (bc_comp (lhs, rhs, INT_MAX) >= 0) {
+    res = bc_sub_positive (lhs, rhs, scratch);
+    sign = lsign;
+  } else {
+    res = bc_sub_positive (rhs, lhs, scratch);
+    sign = rsign;
+  }
+  bc_finish (res, sign, scale, result);
+}
+
+static void bc_mul (const bc_num &lhs, const bc_num &rhs, int scale, bc_num &result) {
+  //the sign follows the exact product, part of which may not be computed
+  int sign = (bc_is_zero (lhs) || bc_is_zero (rhs)) ? 1 : lhs.sign * rhs.sign;
+  scale = std::min (lhs.scale + rhs.scale, scale);
+  bc_scratch scratch;
+  bc_finish (bc_mul_positive (lhs, rhs, scale, scratch), 1, scale, result);
+  result.sign = sign;
+}
+
+static void bc_div (const bc_num &lhs, const bc_num &rhs, int scale, const BCMath::Context &ctx, bc_num &result) {
+  if (bc_is_zero (rhs)) {
+    bc_error (ctx, "Division by zero in function bcdiv");
+    result = bc_num();
+    return;
+  }
+
+  //the quotient limbs hold digits below scale, the sign follows the truncated value
+  int sign = lhs.sign * rhs.sign;
+  bc_scratch scratch;
+  bc_finish (bc_div_positive (lhs, rhs, scale, scratch), 1, scale, result);
+  if (!bc_is_zero (result)) {
+    result.sign = sign;
+  }
+}
+
+static void bc_mod (const bc_num &lhs, const bc_num &rhs, const BCMath::Context &ctx, bc_num &result) {
+  if (lhs.scale != 0) {
+    bc_error (ctx, "First parameter \"" + bc_to_string (lhs) + "\" in function bcmod is not an integer");
+    result = bc_num();
+    return;
+  }
+  if (rhs.scale != 0) {
+    bc_error (ctx, "Second parameter \"" + bc_to_string (rhs) + "\" in function bcmod is not an integer");
+    result = bc_num();
+    return;
+  }
+
+  long long mod = 0;
+  if (bc_int_digits (rhs) <= 18) {
+    for (int i = (int)rhs.limbs.size() - 1; i >= 0; i--) {
+      mod = mod * BC_BASE + rhs.limbs[i];
+    }
+  }
+
+  if (bc_int_digits (rhs) > 18 || mod == 0) {
+    bc_error (ctx, "Second parameter \"" + bc_to_string (rhs) + "\" in function bcmod is not a non zero integer less than 1e18 by absolute value");
+    result = bc_num();
+    return;
+  }
+
+  //one short division pass over the limbs of lhs
+  long long res = 0;
+  int n = (int)lhs.limbs.size();
+  if (mod < BC_BASE) {
+    unsigned long long inv = bc_invert (mod), rem = 0;
+    for (int i = n - 1; i >= 0; i--) {
+      unsigned long long cur = rem * BC_BASE + lhs.limbs[i];
+      rem = cur - bc_div_pre (cur, mod, inv) * mod;
+    }
+    res = (long long)rem;
+  } else {
+#ifdef __SIZEOF_INT128__
+    unsigned long long rem = 0;
+    for (int i = n - 1; i >= 0; i--) {
+      rem = (unsigned long long)(((unsigned __int128)rem * BC_BASE + lhs.limbs[i]) % (unsigned long long)mod);
+    }
+    res = (long long)rem;
+#else
+    for (int i = bc_int_digits (lhs) - 1; i >= 0; i--) {
+      res = res * 2;
+      if (res >= mod) {
+        res -= mod;
+      }
+      res = res * 5 + bc_digit (lhs, i);
+      while (res >= mod) {
+        res -= mod;
+      }
+    }
+#endif
+  }
+
+  result.sign = lhs.sign;
+  result.scale = 0;
+  result.limbs.clear();
+  for (; res > 0; res /= BC_BASE) {
+    result.limbs.push_back ((bc_limb)(res % BC_BASE));
+  }
+}
+
+static void bc_pow (const bc_num &lhs, const bc_num &rhs, const BCMath::Context &ctx, bc_num &result) {
+  if (lhs.scale != 0) {
+    bc_error (ctx, "First parameter \"" + bc_to_string (lhs) + "\" in function bcpow is not an integer");
+    result = bc_num();
+    return;
+  }
+  if (rhs.scale != 0) {
+    bc_error (ctx, "Second parameter \"" + bc_to_string (rhs) + "\" in function bcpow is not an integer");
+    result = bc_num();
+    return;
+  }
+
+  long long deg = 0;
+  if (bc_int_digits (rhs) <= 18) {
+    for (int i = (int)rhs.limbs.size() - 1; i >= 0; i--) {
+      deg = deg * BC_BASE + rhs.limbs[i];
+    }
+  }
+
+  if (bc_int_digits (rhs) > 18 || (rhs.sign < 0 && deg != 0)) {
+    bc_error (ctx, "Second parameter \"" + bc_to_string (rhs) + "\" in function bcpow is not a non negative integer less than 1e18");
+    result = bc_num();
+    return;
+  }
+
+  bc_num mul = lhs;
+  result.sign = 1;
+  result.scale = 0;
+  result.limbs.assign (1, 1);
+  while (deg > 0) {
+    if (deg & 1) {
+      bc_mul (result, mul, 0, result);
+    }
+    bc_mul (mul, mul, 0, mul);
+    deg >>= 1;
+  }
+}
+
+static int bc_compare (const bc_num &lhs, const bc_num &rhs, int scale) {
+  int lsign = bc_is_zero (lhs) ? 1 : lhs.sign;
+  int rsign = bc_is_zero (rhs) ? 1 : rhs.sign;
+  if (lsign != rsign) {
+    return (lsign - rsign) / 2;
+  }
+
+  return lsign * bc_comp (lhs, rhs, scale);
+}
+
+static void bc_round (const bc_num &lhs, int scale, bc_num &result) {
+  int sign = bc_is_zero (lhs) ? 1 : lhs.sign;
+  int round_digit = bc_digit (lhs, -scale - 1);
+
+  bc_mag mag = { lhs.limbs.data(), (int)lhs.limbs.size(), bc_frac_limbs (lhs.scale) };
+  bc_finish (mag, 1, scale, result);
+  if (round_digit >= 5) {
+    bc_limb carry = bc_pow10[bc_frac_limbs (scale) * BC_BASE_DIGITS - scale];
+    for (size_t i = 0; carry; i++) {
+      if (i == result.limbs.size()) {
+        result.limbs.push_back (0);
+      }
+      bc_limb um = result.limbs[i] + carry;
+      carry = (um >= BC_BASE);
+      result.limbs[i] = carry ? um - BC_BASE : um;
+    }
+  }
+  result.sign = sign;
+}
+
+//number of digits computed before the context rounding brings a result to scale
+static int bc_work_scale (const BCMath::Context &ctx, int scale) {
+  return ctx.rounding == BCMath::Context::HALF_UP ? scale + 1 : scale;
+}
+
+//rounds a result computed at bc_work_scale digits down to scale
+static void bc_apply_rounding (const BCMath::Context &ctx, int scale, bc_num &result) {
+  if (ctx.rounding == BCMath::Context::HALF_UP && result.scale > scale) {
+    bc_round (result, scale, result);
+    if (bc_is_zero (result)) {
+      result.sign = 1;
+    }
+  }
+}
+
+const BCMath::Context &BCMath::Context::current () {
+  return bc_context ? *bc_context : bc_default_context;
+}
+
+BCMath::Context::Scope::Scope (const Context &context) : context (context), previous (bc_context) {
+  bc_context = &this->context;
+}
+
+BCMath::Context::Scope::~Scope () {
+  bc_context = previous;
+}
+
+void BCMath::parse (View num) {
+  if (num.empty()) {
+    value = bc_num();
+    return;
+  }
+  if (bc_parse_number (num, value) < 0) {
+    bc_error (Context::current(), "Parameter \"" + num.str() + "\" in BCMath is not a number");
+    value = bc_num();
+  }
+}
+
+std::string BCMath::toString () const {
+  return bc_to_string (value);
+}
+
+char *BCMath::to_chars (char *first, char *last) const {
+  size_t len = bc_string_length (value);
+  if ((size_t)(last - first) < len) {
+    return NULL;
+  }
+  bc_write_number (first, value);
+  return first + len;
+}
+
+size_t BCMath::toStringLength () const {
+  return bc_string_length (value);
+}
+
+void BCMath::assign (unsigned long long magnitude, int sign) {
+  value.limbs.clear();
+  while (magnitude > 0) {
+    value.limbs.push_back ((bc_limb)(magnitude % BC_BASE));
+    magnitude /= BC_BASE;
+  }
+  value.sign = value.limbs.empty() ? 1 : sign;
+  value.scale = 0;
+}
+
+//integer part of |num| in x, false if it needs more than 64 bits
+static bool bc_int_value (const bc_num &num, unsigned long long &x) {
+  int frac = bc_frac_limbs (num.scale);
+  x = 0;
+  for (int i = (int)num.limbs.size() - 1; i >= frac; i--) {
+    if (x > (ULLONG_MAX - num.limbs[i]) / BC_BASE) {
+      return false;
+    }
+    x = x * BC_BASE + num.limbs[i];
+  }
+  return true;
+}
+
+//integer part of num in result, clamped to the range of T, false if it did not fit
+template <class T>
+static bool bc_to_integer (const bc_num &num, T &result) {
+  unsigned long long x;
+  bool fits = bc_int_value (num, x);
+  if (num.sign < 0 && (!fits || x != 0)) {
+    unsigned long long limit = std::numeric_limits<T>::is_signed ? (unsigned long long)std::numeric_limits<T>::max() + 1 : 0;
+    if (!fits || x > limit) {
+      result = std::numeric_limits<T>::min();
+      return false;
+    }
+    result = (T)(-(long long)(x - 1) - 1);
+    return true;
+  }
+  if (!fits || x > (unsigned long long)std::numeric_limits<T>::max()) {
+    result = std::numeric_limits<T>::max();
+    return false;
+  }
+  result = (T)x;
+  return true;
+}
+
+//powers of ten exactly representable in a long double with a 64 bit mantissa
+static const long double bc_pow10_float[] = {
+  1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L,
+  1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+};
+
+static float bc_strto (const char *s, char **end, float) {
+  return strtof (s, end);
+}
+
+static double bc_strto (const char *s, char **end, double) {
+  return strtod (s, end);
+}
+
+static long double bc_strto (const char *s, char **end, long double) {
+  return strtold (s, end);
+}
+
+//num correctly rounded to T in result, false if it overflowed. When the digits form
+//an integer that T holds exactly and the power of ten that scales it is exact too,
+//one multiplication or division rounds correctly; otherwise the text goes through strtod
+template <class T>
+static bool bc_to_float (const bc_num &num, T &result) {
+  const int digits = std::numeric_limits<T>::digits;
+  const int max_pow = std::min (digits * 3 / 7, 27);
+
+  //the significant limbs as one integer x, when it fits in 64 bits, times 10^pow
+  int len = bc_trim (num.limbs.data(), (int)num.limbs.size());
+  int low = 0;
+  while (low < len && num.limbs[low] == 0) {
+    low++;
+  }
+  if (len - low <= 3) {
+    unsigned long long x = 0;
+    bool fits = true;
+    for (int i = len - 1; i >= low && fits; i--) {
+      fits = x <= (ULLONG_MAX - num.limbs[i]) / BC_BASE;
+      x = x * BC_BASE + num.limbs[i];
+    }
+    int pow = (low - bc_frac_limbs (num.scale)) * BC_BASE_DIGITS;
+    while (fits && x != 0 && x % 10 == 0) {
+      x /= 10;
+      pow++;
+    }
+    if (fits && std::abs (pow) <= max_pow && (digits >= 64 || (x >> std::min (digits, 63)) == 0)) {
+      result = pow < 0 ? (T)x / (T)bc_pow10_float[-pow] : (T)x * (T)bc_pow10_float[pow];
+      if (num.sign < 0) {
+        result = -result;
+      }
+      return true;
+    }
+  }
+
+  bc_scratch scratch;
+  int n = bc_string_length (num);
+  char *s = scratch.take<char> (n + 1);
+  bc_write_number (s, num);
+  s[n] = 0;
+  //strtod reads the decimal point of the C locale
+  char *dot = (char *)memchr (s, '.', n);
+  if (dot != NULL) {
+    *dot = *localeconv()->decimal_point;
+  }
+  result = bc_strto (s, NULL, T());
+  return std::fabs (result) <= std::numeric_limits<T>::max();
+}
+
+template <class T>
+static T bc_convert (const bc_num &num, bool (*convert) (const bc_num &, T &), const char *type, const char *function) {
+  T result;
+  if (!convert (num, result)) {
+    bc_error (BCMath::Context::current(), "Value \"" + bc_to_string (num) + "\" is out of range of " + type + " in function " + function);
+  }
+  return result;
+}
+
+int BCMath::toInt () const {
+  return bc_convert<int> (value, bc_to_integer<int>, "int", "toInt");
+}
+
+bool BCMath::toInt (int &result) const {
+  return bc_to_integer (value, result);
+}
+
+unsigned int BCMath::toUInt () const {
+  return bc_convert<unsigned int> (value, bc_to_integer<unsigned int>, "unsigned int", "toUInt");
+}
+
+bool BCMath::toUInt (unsigned int &result) const {
+  return bc_to_integer (value, result);
+}
+
+long long BCMath::toLongLong () const {
+  return bc_convert<long long> (value, bc_to_integer<long long>, "long long", "toLongLong");
+}
+
+bool BCMath::toLongLong (long long &result) const {
+  return bc_to_integer (value, result);
+}
+
+unsigned long long BCMath::toULongLong () const {
+  return bc_convert<unsigned long long> (value, bc_to_integer<unsigned long long>, "unsigned long long", "toULongLong");
+}
+
+bool BCMath::toULongLong (unsigned long long &result) const {
+  return bc_to_integer (value, result);
+}
+
+long double BCMath::toLongDouble () const {
+  return bc_convert<long double> (value, bc_to_float<long double>, "long double", "toLongDouble");
+}
+
+bool BCMath::toLongDouble (long double &result) const {
+  return bc_to_float (value, result);
+}
+
+double BCMath::toDouble () const {
+  return bc_convert<double> (value, bc_to_float<double>, "double", "toDouble");
+}
+
+bool BCMath::toDouble (double &result) const {
+  return bc_to_float (value, result);
+}
+
+float BCMath::toFloat () const {
+  return bc_convert<float> (value, bc_to_float<float>, "float", "toFloat");
+}
+
+bool BCMath::toFloat (float &result) const {
+  return bc_to_float (value, result);
+}
+
+//x = c / 10^s for the least s from which some integer c gives back x, with c the
+//one nearest to x * 10^s. The candidates are checked by one correctly rounded
+//division, which needs c < 2^digits and an exact power of ten; false if none is
+//found within those limits
+template <class T>
+static bool bc_shortest_fast (T x, unsigned long long &c, int &s) {
+  const int digits = std::numeric_limits<T>::digits;
+  const int max_pow = std::min (digits * 3 / 7, 27);
+  const T limit = std::ldexp ((T)1, std::min (digits, 64));
+  if (x >= limit / 2) {
+    return false;
+  }
+
+  for (s = 0; s <= max_pow; s++) {
+    T pow = (T)bc_pow10_float[s];
+    T y = x * pow;
+    if (y >= limit / 2) {
+      return false;
+    }
+    //x * 10^s is rounded, so its nearest integer is one of these
+    unsigned long long n = (unsigned long long)y;
+    bool found = false;
+    for (unsigned long long k = n > 0 ? n - 1 : 0; k <= n + 2; k++) {
+      if (k > 0 && (T)k / pow == x && (!found || std::fabs ((T)k - y) < std::fabs ((T)c - y))) {
+        c = k;
+        found = true;
+      }
+    }
+    if (found) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//x as %e text with p significant digits, true if strtod reads it back as x
+template <class T>
+static bool bc_print_float (T x, int p, char *buf, int size) {
+  snprintf (buf, size, "%.*Le", p - 1, (long double)x);
+  return bc_strto (buf, NULL, T()) == x;
+}
+
+//digits and exponent of the shortest %e text of x that strtod reads back as x; most
+//values need about digits10 digits, so the search starts there
+template <class T>
+static void bc_shortest_slow (T x, char *digits, int &len, int &exp) {
+  char buf[64];
+  int p = std::numeric_limits<T>::digits10;
+  if (bc_print_float (x, p, buf, sizeof (buf))) {
+    while (p > 1 && bc_print_float (x, p - 1, buf, sizeof (buf))) {
+      p--;
+    }
+    bc_print_float (x, p, buf, sizeof (buf));
+  } else {
+    while (p < std::numeric_limits<T>::max_digits10 && !bc_print_float (x, p + 1, buf, sizeof (buf))) {
+      p++;
+    }
+  }
+
+  //the decimal point of the C locale is skipped together with the other non-digits
+  const char *e = strchr (buf, 'e');
+  len = 0;
+  for (const char *t = buf; t < e; t++) {
+    if ('0' <= *t && *t <= '9') {
+      digits[len++] = *t;
+    }
+  }
+  exp = atoi (e + 1) - (len - 1);
+}
+
+//num = x written with the fewest significant digits that convert back to x
+template <class T>
+static bool bc_from_float (T x, bc_num &num) {
+  if (!std::isfinite (x)) {
+    return false;
+  }
+  if (x == 0) {
+    num = bc_num();
+    return true;
+  }
+
+  //the fast path gives at most the 20 digits of an unsigned long long
+  char digits[std::numeric_limits<T>::max_digits10 > 20 ? std::numeric_limits<T>::max_digits10 : 20];
+  int len, exp;
+  unsigned long long c = 0;
+  int s;
+  if (bc_shortest_fast (std::fabs (x), c, s)) {
+    len = 0;
+    for (; c > 0; c /= 10) {
+      digits[len++] = (char)('0' + c % 10);
+    }
+    std::reverse (digits, digits + len);
+    exp = -s;
+  } else {
+    bc_shortest_slow (std::fabs (x), digits, len, exp);
+  }
+  while (len > 1 && digits[len - 1] == '0') {
+    len--;
+    exp++;
+  }
+
+  //the digits as plain text, with the zeros that the exponent stands for
+  bc_scratch scratch;
+  char *text = scratch.take<char> (std::max (len + exp, 1) + std::max (-exp, 0) + 2);
+  char *t = text;
+  if (x < 0) {
+    *t++ = '-';
+  }
+  if (len + exp <= 0) {
+    *t++ = '0';
+    *t++ = '.';
+    t = std::fill_n (t, -(len + exp), '0');
+    t = std::copy (digits, digits + len, t);
+  } else {
+    for (int i = 0; i < len + exp; i++) {
+      *t++ = i < len ? digits[i] : '0';
+    }
+    if (exp < 0) {
+      *t++ = '.';
+      t = std::copy (digits + len + exp, digits + len, t);
+    }
+  }
+  return bc_parse_number (text, (int)(t - text), num) >= 0;
+}
+
+//num = x exactly: x = m * 2^e becomes m * 2^e, or m * 5^-e with -e fractional digits
+template <class T>
+static bool bc_from_float_exact (T x, bc_num &num) {
+  if (!std::isfinite (x)) {
+    return false;
+  }
+  num = bc_num();
+  if (x == 0) {
+    return true;
+  }
+
+  //the mantissa as an integer without its trailing zero bits, which T holds exactly
+  //whatever its width
+  int e;
+  const int digits = std::numeric_limits<T>::digits;
+  T m = std::ldexp (std::fabs (std::frexp (x, &e)), digits);
+  e -= digits;
+  while (std::fmod (m, (T)2) == 0) {
+    m /= 2;
+    e++;
+  }
+
+  //split into 29 bit parts, which fit a limb, and put together again in base 10^9
+  const T part = (T)((bc_limb)1 << 29);
+  bc_limb parts[(digits + 28) / 29];
+  int n = 0;
+  for (; m > 0; n++) {
+    T low = std::fmod (m, part);
+    parts[n] = (bc_limb)low;
+    m = (m - low) / part;
+  }
+  std::vector<bc_limb> &limbs = num.limbs;
+  for (int i = n - 1; i >= 0; i--) {
+    bc_limb carry = bc_mul_1 (limbs.data(), limbs.data(), (int)limbs.size(), (bc_limb)1 << 29);
+    if (carry) {
+      limbs.push_back (carry);
+    }
+    carry = parts[i];
+    for (size_t k = 0; carry; k++) {
+      if (k == limbs.size()) {
+        limbs.push_back (0);
+      }
+      bc_limb um = limbs[k] + carry;
+      carry = (um >= BC_BASE);
+      limbs[k] = carry ? um - BC_BASE : um;
+    }
+  }
+  int scale = std::max (-e, 0);
+  //2^29 and 5^12 are the largest powers below BC_BASE
+  for (int k = std::abs (e); k > 0; ) {
+    int step = std::min (k, e > 0 ? 29 : 12);
+    bc_limb f = e > 0 ? (bc_limb)1 << step : (bc_limb)std::pow (5.0, step);
+    bc_limb carry = bc_mul_1 (limbs.data(), limbs.data(), (int)limbs.size(), f);
+    if (carry) {
+      limbs.push_back (carry);
+    }
+    k -= step;
+  }
+  //the digits are lined up so that the lowest scale of them are the fraction
+  int pad = bc_frac_limbs (scale) * BC_BASE_DIGITS - scale;
+  bc_limb carry = bc_mul_1 (limbs.data(), limbs.data(), (int)limbs.size(), bc_pow10[pad]);
+  if (carry) {
+    limbs.push_back (carry);
+  }
+  num.sign = x < 0 ? -1 : 1;
+  num.scale = scale;
+  if ((int)limbs.size() < bc_frac_limbs (scale)) {
+    limbs.resize (bc_frac_limbs (scale), 0);
+  }
+  return true;
+}
+
+//non-finite values have no decimal form
+template <class T>
+static void bc_float_error (T x) {
+  bc_error (BCMath::Context::current(), std::string ("Parameter \"") + (std::isnan (x) ? "nan" : x < 0 ? "-inf" : "inf") + "\" in BCMath is not a number");
+}
+
+void BCMath::assign (float num) {
+  if (!bc_from_float (num, value)) {
+    bc_float_error (num);
+    value = bc_num();
+  }
+}
+
+void BCMath::assign (double num) {
+  if (!bc_from_float (num, value)) {
+    bc_float_error (num);
+    value = bc_num();
+  }
+}
+
+void BCMath::assign (long double num) {
+  if (!bc_from_float (num, value)) {
+    bc_float_error (num);
+    value = bc_num();
+  }
+}
+
+BCMath BCMath::exact (float num) {
+  BCMath result;
+  if (!bc_from_float_exact (num, result.value)) {
+    bc_float_error (num);
+  }
+  return result;
+}
+
+BCMath BCMath::exact (double num) {
+  BCMath result;
+  if (!bc_from_float_exact (num, result.value)) {
+    bc_float_error (num);
+  }
+  return result;
+}
+
+BCMath BCMath::exact (long double num) {
+  BCMath result;
+  if (!bc_from_float_exact (num, result.value)) {
+    bc_float_error (num);
+  }
+  return result;
+}
+
+void BCMath::add (const bc_num &lhs, const bc_num &rhs, int rsign, bc_num &result) {
+  const Context &ctx = Context::current();
+  bc_add (lhs, lhs.sign, rhs, rsign * rhs.sign, bc_work_scale (ctx, ctx.scale), result);
+  bc_apply_rounding (ctx, ctx.scale, result);
+}
+
+void BCMath::mul (const bc_num &lhs, const bc_num &rhs, bc_num &result) {
+  const Context &ctx = Context::current();
+  bc_mul (lhs, rhs, bc_work_scale (ctx, ctx.scale), result);
+  bc_apply_rounding (ctx, ctx.scale, result);
+}
+
+void BCMath::div (const bc_num &lhs, const bc_num &rhs, bc_num &result) {
+  const Context &ctx = Context::current();
+  bc_div (lhs, rhs, bc_work_scale (ctx, ctx.scale), ctx, result);
+  bc_apply_rounding (ctx, ctx.scale, result);
+}
+
+void BCMath::mod (const bc_num &lhs, const bc_num &rhs, bc_num &result) {
+  bc_mod (lhs, rhs, Context::current(), result);
+}
+
+void BCMath::pow (const bc_num &lhs, const bc_num &rhs, bc_num &result) {
+  bc_pow (lhs, rhs, Context::current(), result);
+}
+
+void BCMath::round (const bc_num &lhs, int scale, bc_num &result) {
+  bc_round (lhs, scale, result);
+}
+
+int BCMath::comp (const bc_num &lhs, const bc_num &rhs) {
+  return bc_compare (lhs, rhs, Context::current().scale);
+}
+
+//registers of lazy expressions, taken and given back in stack order; a deque keeps
+//them in place as it grows
+static thread_local std::deque<bc_num> bc_lazy_regs;
+static thread_local size_t bc_lazy_used = 0;
+
+bc_num &BCMath::lazy_acquire () {
+  if (bc_lazy_used == bc_lazy_regs.size()) {
+    bc_lazy_regs.push_back (bc_num());
+  }
+  return bc_lazy_regs[bc_lazy_used++];
+}
+
+void BCMath::lazy_release () {
+  bc_lazy_used--;
+}
+
+BCMath::Divisor::Divisor (const BCMath &divisor) {
+  const bc_num &d = divisor.value;
+  sign = d.sign;
+  frac = bc_frac_limbs (d.scale);
+  low = 0;
+  norm = 1;
+  inv = 0;
+
+  int vlen = bc_trim (d.limbs.data(), (int)d.limbs.size());
+  if (vlen == 0) {
+    return;
+  }
+  while (d.limbs[low] == 0) {
+    low++;
+  }
+  limbs.assign (d.limbs.begin() + low, d.limbs.begin() + vlen);
+
+  int n = (int)limbs.size();
+  if (n == 1) {
+    inv = bc_invert (limbs[0]);
+  } else if (n >= BC_BARRETT_THRESHOLD) {
+    std::vector<bc_limb> u (2 * n + 1, 0);
+    u[2 * n] = 1;
+    recip.assign (n + 2, 0);
+    bc_div_limbs (recip.data(), u.data(), 2 * n + 1, limbs.data(), n);
+    BC_ASSERT (recip[n + 1] == 0);
+    recip.pop_back();
+  } else {
+    norm = BC_BASE / (limbs[n - 1] + 1);
+    normalised.resize (n);
+    bc_mul_1 (normalised.data(), limbs.data(), n, norm);
+    inv = bc_invert (normalised[n - 1]);
+  }
+}
+
+void BCMath::Divisor::divide (const bc_num &lhs, int scale, const Context &ctx, bc_num &result) const {
+  if (limbs.empty()) {
+    bc_error (ctx, "Division by zero in function bcdiv");
+    result = bc_num();
+    return;
+  }
+
+  int work_scale = bc_work_scale (ctx, scale);
+  int res_frac = bc_frac_limbs (work_scale);
+  int vlen = (int)limbs.size();
+  bc_scratch scratch;
+  bc_limb *u;
+  int ulen = bc_div_dividend (lhs, res_frac, frac, low, scratch, u);
+  int qlen = std::max (ulen - vlen + 1, res_frac);
+  bc_limb *q = scratch.zeros<bc_limb> (qlen);
+  if (ulen >= vlen) {
+    if (vlen == 1) {
+      bc_div_1_pre (q, u, ulen, limbs[0], inv);
+    } else if (!recip.empty()) {
+      bc_div_barrett (q, u, ulen, limbs.data(), vlen, recip.data());
+    } else {
+      u[ulen] = bc_mul_1 (u, u, ulen, norm);
+      bc_div_knuth_pre (q, u, ulen, normalised.data(), vlen, inv);
+    }
+  }
+
+  int res_sign = lhs.sign * sign;
+  bc_mag res = { q, qlen, res_frac };
+  bc_finish (res, 1, work_scale, result);
+  if (!bc_is_zero (result)) {
+    result.sign = res_sign;
+  }
+  bc_apply_rounding (ctx, scale, result);
+}
+
+std::string BCMath::Divisor::bcdiv (BCMath::View lhs, int scale) const {
+  return Context::current().bcdiv (lhs, *this, scale);
+}
+
+void BCMath::Divisor::bcdiv_into (std::string &out, BCMath::View lhs, int scale) const {
+  Context::current().bcdiv_into (out, lhs, *this, scale);
+}
+
+void BCMath::div (const bc_num &lhs, const Divisor &rhs, bc_num &result) {
+  const Context &ctx = Context::current();
+  rhs.divide (lhs, ctx.scale, ctx, result);
+}
+
+//carries every column but the top one into the next, leaving cols[0, n - 1) in
+//[0, BC_BASE) and the sign of the sum in the top column
+static void bc_carry_signed (long long *cols, int n) {
+  long long carry = 0;
+  for (int i = 0; i + 1 < n; i++) {
+    long long x = cols[i] + carry;
+    carry = x / BC_BASE;
+    x -= carry * BC_BASE;
+    if (x < 0) {
+      x += BC_BASE;
+      carry--;
+    }
+    cols[i] = x;
+  }
+  if (n > 0) {
+    cols[n - 1] += carry;
+  }
+}
+
+void BCMath::Accumulator::add (const bc_mag &x, int sign) {
+  if (x.frac > frac) {
+    cols.insert (cols.begin(), x.frac - frac, 0);
+    frac = x.frac;
+  }
+  int xlen = bc_trim (x.limbs, x.len);
+  int from = frac - x.frac;
+  if ((int)cols.size() < from + xlen) {
+    cols.resize (from + xlen, 0);
+  }
+
+  long long *c = cols.data() + from;
+  const bc_limb *a = x.limbs;
+  if (sign < 0) {
+    for (int i = 0; i < xlen; i++) {
+      c[i] -= a[i];
+    }
+  } else {
+    for (int i = 0; i < xlen; i++) {
+      c[i] += a[i];
+    }
+  }
+  if (++pending == BC_ACC_PENDING) {
+    normalise();
+  }
+}
+
+void BCMath::Accumulator::add (const bc_num &x) {
+  bc_mag mag = { x.limbs.data(), (int)x.limbs.size(), bc_frac_limbs (x.scale) };
+  add (mag, x.sign);
+}
+
+//the full product is computed, so every digit of it is kept
+void BCMath::Accumulator::addmul (const bc_num &lhs, const bc_num &rhs) {
+  bc_scratch scratch;
+  add (bc_mul_positive (lhs, rhs, lhs.scale + rhs.scale, scratch), lhs.sign * rhs.sign);
+}
+
+//leaves every column in (-BC_BASE, BC_BASE), the top one split into new columns
+//as needed, so that BC_ACC_PENDING more additions fit in any column again
+void BCMath::Accumulator::normalise () {
+  bc_carry_signed (cols.data(), (int)cols.size());
+  while (!cols.empty() && (cols.back() >= (long long)BC_BASE || cols.back() <= -(long long)BC_BASE)) {
+    long long top = cols.back();
+    cols.back() = top % BC_BASE;
+    cols.push_back (top / BC_BASE);
+  }
+  pending = 0;
+}
+
+void BCMath::Accumulator::add (const BCMath &x) {
+  add (x.value);
+}
+
+void BCMath::Accumulator::add (const std::string &x) {
+  add (View (x));
+}
+
+void BCMath::Accumulator::add (const char *x) {
+  add (View (x));
+}
+
+void BCMath::Accumulator::add (View x) {
+  if (x.empty()) {
+    return;
+  }
+  bc_num &num = bc_lhs;
+  if (bc_parse_number (x, num) < 0) {
+    bc_error (Context::current(), "Parameter \"" + x.str() + "\" in BCMath::Accumulator::add is not a number");
+    return;
+  }
+  add (num);
+}
+
+void BCMath::Accumulator::addmul (const BCMath &lhs, const BCMath &rhs) {
+  addmul (lhs.value, rhs.value);
+}
+
+void BCMath::Accumulator::clear () {
+  cols.clear();
+  frac = 0;
+  pending = 0;
+}
+
+BCMath BCMath::Accumulator::result (int scale) const {
+  const Context &ctx = Context::current();
+  if (scale == INT_MIN) {
+    scale = ctx.scale;
+  }
+  if (scale < 0) {
+    bc_error (ctx, "Wrong parameter scale = " + std::to_string (scale) + " in function BCMath::Accumulator::result");
+    scale = 0;
+  }
+
+  BCMath res;
+  finish (scale, ctx, res.value);
+  return res;
+}
+
+void BCMath::Accumulator::finish (int scale, const Context &ctx, bc_num &result) const {
+  //the magnitude gets two more limbs for what is left in the top column
+  int n = (int)cols.size();
+  bc_scratch scratch;
+  long long *c = scratch.take<long long> (n);
+  std::copy (cols.begin(), cols.end(), c);
+  bc_carry_signed (c, n);
+  int sign = 1;
+  if (n > 0 && c[n - 1] < 0) {
+    sign = -1;
+    for (int i = 0; i < n; i++) {
+      c[i] = -cols[i];
+    }
+    bc_carry_signed (c, n);
+  }
+
+  bc_limb *r = scratch.take<bc_limb> (n + 2);
+  for (int i = 0; i + 1 < n; i++) {
+    r[i] = (bc_limb)c[i];
+  }
+  unsigned long long top = n > 0 ? c[n - 1] : 0;
+  for (int i = std::max (n - 1, 0); i < n + 2; i++) {
+    r[i] = (bc_limb)(top % BC_BASE);
+    top /= BC_BASE;
+  }
+
+  bc_mag mag = { r, n + 2, frac };
+  bc_finish (mag, sign, bc_work_scale (ctx, scale), result);
+  bc_apply_rounding (ctx, scale, result);
+}
+
+static size_t bc_varint_length (unsigned long long x) {
+  size_t len = 1;
+  while (x >= 0x80) {
+    x >>= 7;
+    len++;
+  }
+  return len;
+}
+
+static unsigned char *bc_put_varint (unsigned char *p, unsigned long long x) {
+  while (x >= 0x80) {
+    *p++ = (unsigned char)(x | 0x80);
+    x >>= 7;
+  }
+  *p++ = (unsigned char)x;
+  return p;
+}
+
+//reads a varint of at most limit from [p, end) and moves p past it
+static bool bc_get_varint (const unsigned char *&p, const unsigned char *end, unsigned long long limit, unsigned long long &x) {
+  x = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    unsigned char b = *p++;
+    x |= (unsigned long long)(b & 0x7f) << shift;
+    if (x > limit) {
+      return false;
+    }
+    if (!(b & 0x80)) {
+      return shift == 0 || b != 0;
+    }
+  }
+  return false;
+}
+
+//padding digits below the scale in the lowest limb, which the binary form leaves out
+static int bc_scale_pad (int scale) {
+  return bc_frac_limbs (scale) * BC_BASE_DIGITS - scale;
+}
+
+//limb i of num as the binary form stores it
+static bc_limb bc_stored_limb (const bc_num &num, size_t i) {
+  return i == 0 ? num.limbs[0] / bc_pow10[bc_scale_pad (num.scale)] : num.limbs[i];
+}
+
+//reads a varint that bc_decode has already checked
+static bc_limb bc_read_limb_varint (const unsigned char *&p) {
+  bc_limb x = 0;
+  for (int shift = 0; ; shift += 7) {
+    unsigned char b = *p++;
+    x |= (bc_limb)(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      return x;
+    }
+  }
+}
+
+static size_t bc_encoded_length (const bc_num &num) {
+  int ints = bc_int_limbs (num);
+  size_t len = 2;
+  if (ints >= BC_HEAD_INTS) {
+    len += bc_varint_length (ints - BC_HEAD_INTS);
+  }
+  if (num.scale >= BC_HEAD_SCALE) {
+    len += bc_varint_length (num.scale - BC_HEAD_SCALE);
+  }
+  for (size_t i = 0; i < num.limbs.size(); i++) {
+    len += bc_varint_length (bc_stored_limb (num, i));
+  }
+  return len;
+}
+
+static void bc_encode (unsigned char *p, const bc_num &num) {
+  int ints = bc_int_limbs (num);
+  *p++ = BC_ENCODING_VERSION;
+  *p++ = (unsigned char)((num.sign < 0) | std::min (ints, BC_HEAD_INTS) << 1 | std::min (num.scale, BC_HEAD_SCALE) << 4);
+  if (ints >= BC_HEAD_INTS) {
+    p = bc_put_varint (p, ints - BC_HEAD_INTS);
+  }
+  if (num.scale >= BC_HEAD_SCALE) {
+    p = bc_put_varint (p, num.scale - BC_HEAD_SCALE);
+  }
+  for (size_t i = 0; i < num.limbs.size(); i++) {
+    p = bc_put_varint (p, bc_stored_limb (num, i));
+  }
+}
+
+//checks that [s, s + size) starts with the binary form of a number as bc_parse_number
+//would leave it: limbs below BC_BASE, no zero top limb, no digits below the scale, no
+//negative zero without a fraction and no overlong varints. Returns the bytes it takes,
+//or 0 if it is not valid
+static size_t bc_decode (const unsigned char *s, size_t size, int &sign, int &scale, const unsigned char *&limbs, int &len) {
+  const unsigned char *p = s, *end = s + size;
+  if (size < 2 || *p++ != BC_ENCODING_VERSION) {
+    return 0;
+  }
+  unsigned char head = *p++;
+  unsigned long long ints = (head >> 1) & BC_HEAD_INTS, x = 0;
+  unsigned long long sc = head >> 4;
+  if (ints == BC_HEAD_INTS) {
+    if (!bc_get_varint (p, end, INT_MAX / BC_BASE_DIGITS - BC_HEAD_INTS, x)) {
+      return 0;
+    }
+    ints += x;
+  }
+  if (sc == BC_HEAD_SCALE) {
+    if (!bc_get_varint (p, end, INT_MAX - BC_BASE_DIGITS - BC_HEAD_SCALE, x)) {
+      return 0;
+    }
+    sc += x;
+  }
+
+  scale = (int)sc;
+  sign = (head & 1) ? -1 : 1;
+  //every limb takes a byte at least
+  unsigned long long n = bc_frac_limbs (scale) + ints;
+  if ((size_t)(end - p) < n || (sign < 0 && n == 0)) {
+    return 0;
+  }
+  limbs = p;
+  len = (int)n;
+  for (int i = 0; i < len; i++) {
+    if (!bc_get_varint (p, end, (i == 0 ? BC_BASE / bc_pow10[bc_scale_pad (scale)] : BC_BASE) - 1, x)) {
+      return 0;
+    }
+  }
+  if (ints > 0 && x == 0) {
+    return 0;
+  }
+  return p - s;
+}
+
+void BCMath::serialize (std::string &out) const {
+  size_t pos = out.size();
+  out.resize (pos + bc_encoded_length (value));
+  bc_encode ((unsigned char *)&out[pos], value);
+}
+
+char *BCMath::serialize (char *first, char *last) const {
+  size_t len = bc_encoded_length (value);
+  if ((size_t)(last - first) < len) {
+    return NULL;
+  }
+  bc_encode ((unsigned char *)first, value);
+  return first + len;
+}
+
+size_t BCMath::serializedLength () const {
+  return bc_encoded_length (value);
+}
+
+BCMath BCMath::deserialize (const char *data, size_t len) {
+  Encoded num (data, len);
+  if (num.valid() && num.size() != len) {
+    bc_error (Context::current(), "Data in BCMath::deserialize has " + std::to_string (len - num.size()) + " bytes after the number");
+    return BCMath();
+  }
+  return num.value();
+}
+
+BCMath::Encoded::Encoded (const char *data, size_t size) : limbs (NULL), len (0), scale (0), sign (1), bytes (0), ok (false) {
+  bytes = bc_decode ((const unsigned char *)data, size, sign, scale, limbs, len);
+  ok = bytes > 0;
+  if (!ok) {
+    bc_error (Context::current(), "Data in BCMath::Encoded is not a valid encoding of a number");
+    limbs = NULL;
+    len = 0;
+    scale = 0;
+    sign = 1;
+  }
+}
+
+void BCMath::Encoded::load (bc_num &num) const {
+  num.sign = sign;
+  num.scale = scale;
+  num.limbs.resize (len);
+  const unsigned char *p = limbs;
+  for (int i = 0; i < len; i++) {
+    num.limbs[i] = bc_read_limb_varint (p);
+  }
+  if (len > 0) {
+    num.limbs[0] *= bc_pow10[bc_scale_pad (scale)];
+  }
+}
+
+BCMath BCMath::Encoded::value () const {
+  BCMath res;
+  load (res.value);
+  return res;
+}
+
+BCMath BCMath::Encoded::operator+ (const Encoded &o) const {
+  BCMath res;
+  load (bc_lhs);
+  o.load (bc_rhs);
+  add (bc_lhs, bc_rhs, 1, res.value);
+  return res;
+}
+
+BCMath BCMath::Encoded::operator- (const Encoded &o) const {
+  BCMath res;
+  load (bc_lhs);
+  o.load (bc_rhs);
+  add (bc_lhs, bc_rhs, -1, res.value);
+  return res;
+}
+
+BCMath BCMath::Encoded::operator* (const Encoded &o) const {
+  BCMath res;
+  load (bc_lhs);
+  o.load (bc_rhs);
+  mul (bc_lhs, bc_rhs, res.value);
+  return res;
+}
+
+BCMath BCMath::Encoded::operator/ (const Encoded &o) const {
+  BCMath res;
+  load (bc_lhs);
+  o.load (bc_rhs);
+  div (bc_lhs, bc_rhs, res.value);
+  return res;
+}
+
+int BCMath::Encoded::compare (const Encoded &o) const {
+  load (bc_lhs);
+  o.load (bc_rhs);
+  return comp (bc_lhs, bc_rhs);
+}
+
+//the limbs of num that its key holds, from top down to bottom: those from the top
+//nonzero one, or the first fractional one, down to the lowest nonzero fractional
+//one, or the units limb. False if num is zero
+static bool bc_key_range (const bc_num &num, int &bottom, int &top) {
+  int hi = bc_trim (num.limbs.data(), (int)num.limbs.size()) - 1;
+  if (hi < 0) {
+    return false;
+  }
+  int frac = bc_frac_limbs (num.scale);
+  int lo = 0;
+  while (num.limbs[lo] == 0) {
+    lo++;
+  }
+  top = std::max (hi, frac - 1);
+  bottom = std::min (lo, frac);
+  return true;
+}
+
+static size_t bc_key_length (const bc_num &num) {
+  int bottom, top;
+  if (!bc_key_range (num, bottom, top)) {
+    return 1;
+  }
+  return 6 + 4 * (size_t)(top - bottom + 1);
+}
+
+static void bc_put_key_word (unsigned char *p, unsigned int x) {
+  p[0] = (unsigned char)(x >> 24);
+  p[1] = (unsigned char)(x >> 16);
+  p[2] = (unsigned char)(x >> 8);
+  p[3] = (unsigned char)x;
+}
+
+static unsigned int bc_get_key_word (const unsigned char *p) {
+  return (unsigned int)p[0] << 24 | (unsigned int)p[1] << 16 | (unsigned int)p[2] << 8 | p[3];
+}
+
+//the key of num: its class, the number of its integer limbs, the limbs of
+//bc_key_range, all big endian, and a terminator. Numbers below one start at the
+//first fractional limb, so leading zero limbs order them; every limb of the key
+//has a place in the number, which bounds the number by the length of the key.
+//Everything after the class is complemented for negative numbers, so that larger
+//magnitudes come first
+static void bc_write_key (unsigned char *p, const bc_num &num) {
+  int bottom, top;
+  if (!bc_key_range (num, bottom, top)) {
+    *p = BC_KEY_ZERO;
+    return;
+  }
+  unsigned int flip = num.sign < 0 ? 0xffffffffu : 0;
+  *p++ = num.sign < 0 ? BC_KEY_NEGATIVE : BC_KEY_POSITIVE;
+  bc_put_key_word (p, (unsigned int)(top + 1 - bc_frac_limbs (num.scale)) ^ flip);
+  p += 4;
+  for (int i = top; i >= bottom; i--) {
+    bc_put_key_word (p, (num.limbs[i] + BC_KEY_LIMB) ^ flip);
+    p += 4;
+  }
+  *p = (unsigned char)flip;
+}
+
+//reads a key written by bc_write_key, false if [p, p + len) is not exactly one
+static bool bc_read_key (const unsigned char *p, size_t len, bc_num &num) {
+  if (len == 1 && p[0] == BC_KEY_ZERO) {
+    num = bc_num();
+    return true;
+  }
+  if (len < 10 || (len - 6) % 4 != 0 || (p[0] != BC_KEY_NEGATIVE && p[0] != BC_KEY_POSITIVE)) {
+    return false;
+  }
+  unsigned int flip = p[0] == BC_KEY_NEGATIVE ? 0xffffffffu : 0;
+  if (p[len - 1] != (unsigned char)flip) {
+    return false;
+  }
+
+  //the integer limbs are all in the key, so their number is bounded by its length
+  size_t count = (len - 6) / 4;
+  size_t ints = bc_get_key_word (p + 1) ^ flip;
+  if (ints > count || ints > INT_MAX / BC_BASE_DIGITS || count - ints > (INT_MAX - BC_BASE_DIGITS) / BC_BASE_DIGITS) {
+    return false;
+  }
+  size_t frac = count - ints;
+
+  num.limbs.resize (count);
+  for (size_t k = 0; k < count; k++) {
+    unsigned int x = bc_get_key_word (p + 5 + 4 * k) ^ flip;
+    if (x < BC_KEY_LIMB || x - BC_KEY_LIMB >= BC_BASE) {
+      return false;
+    }
+    num.limbs[count - 1 - k] = x - BC_KEY_LIMB;
+  }
+  //the top integer limb and the bottom fractional one are not zero
+  if ((ints > 0 && num.limbs[count - 1] == 0) || (frac > 0 && num.limbs[0] == 0)) {
+    return false;
+  }
+
+  //the scale ends at the last nonzero digit of the bottom limb
+  num.scale = (int)frac * BC_BASE_DIGITS;
+  if (frac > 0) {
+    for (bc_limb x = num.limbs[0]; x % 10 == 0; x /= 10) {
+      num.scale--;
+    }
+  }
+  num.sign = flip ? -1 : 1;
+  return true;
+}
+
+void BCMath::toKey (std::string &out) const {
+  size_t pos = out.size();
+  out.resize (pos + bc_key_length (value));
+  bc_write_key ((unsigned char *)&out[pos], value);
+}
+
+std::string BCMath::toKey () const {
+  std::string out;
+  toKey (out);
+  return out;
+}
+
+size_t BCMath::keyLength () const {
+  return bc_key_length (value);
+}
+
+BCMath BCMath::fromKey (const char *data, size_t len) {
+  BCMath res;
+  if (!bc_read_key ((const unsigned char *)data, len, res.value)) {
+    bc_error (Context::current(), "Data in BCMath::fromKey is not a valid key");
+    res.value = bc_num();
+  }
+  return res;
+}
+
+struct bc_key {
+  const unsigned char *key;
+  size_t len;
+  size_t index;
+};
+
+//byte depth of a key plus one, or 0 past its end
+static inline int bc_key_byte (const bc_key &x, size_t depth) {
+  return depth < x.len ? x.key[depth] + 1 : 0;
+}
+
+//order of keys that are equal before depth
+static bool bc_key_less (const bc_key &x, const bc_key &y, size_t depth) {
+  size_t n = std::min (x.len, y.len);
+  int c = memcmp (x.key + depth, y.key + depth, n - depth);
+  return c < 0 || (c == 0 && x.len < y.len);
+}
+
+//stable MSD radix sort of keys[0, n) one byte at a time, with a stack of buckets
+//in place of recursion, since keys can share long prefixes
+static void bc_radix_sort (bc_key *keys, size_t n, bc_key *tmp) {
+  struct bucket {
+    size_t from;
+    size_t n;
+    size_t depth;
+  };
+  std::vector<bucket> todo;
+  bucket all = { 0, n, 0 };
+  todo.push_back (all);
+
+  while (!todo.empty()) {
+    bucket b = todo.back();
+    todo.pop_back();
+    bc_key *a = keys + b.from;
+
+    if (b.n <= BC_RADIX_THRESHOLD) {
+      for (size_t i = 1; i < b.n; i++) {
+        bc_key x = a[i];
+        size_t j = i;
+        for (; j > 0 && bc_key_less (x, a[j - 1], b.depth); j--) {
+          a[j] = a[j - 1];
+        }
+        a[j] = x;
+      }
+      continue;
+    }
+
+    size_t count[257] = { 0 };
+    for (size_t i = 0; i < b.n; i++) {
+      count[bc_key_byte (a[i], b.depth)]++;
+    }
+
+    //keys that all share this byte go on to the next one, those that all ended are equal
+    int c = bc_key_byte (a[0], b.depth);
+    if (count[c] == b.n) {
+      if (c > 0) {
+        b.depth++;
+        todo.push_back (b);
+      }
+      continue;
+    }
+
+    size_t pos[257];
+    size_t sum = 0;
+    for (int k = 0; k < 257; k++) {
+      pos[k] = sum;
+      sum += count[k];
+    }
+    for (size_t i = 0; i < b.n; i++) {
+      tmp[pos[bc_key_byte (a[i], b.depth)]++] = a[i];
+    }
+    std::copy (tmp, tmp + b.n, a);
+
+    for (int k = 1; k < 257; k++) {
+      if (count[k] > 1) {
+        bucket next = { b.from + pos[k] - count[k], count[k], b.depth + 1 };
+        todo.push_back (next);
+      }
+    }
+  }
+}
+
+void BCMath::sort (std::vector<BCMath> &values) {
+  size_t n = values.size();
+  std::vector<bc_key> keys (n), tmp (n);
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    keys[i].len = bc_key_length (values[i].value);
+    keys[i].index = i;
+    total += keys[i].len;
+  }
+
+  std::vector<unsigned char> buf (total);
+  unsigned char *p = buf.data();
+  for (size_t i = 0; i < n; i++) {
+    bc_write_key (p, values[i].value);
+    keys[i].key = p;
+    p += keys[i].len;
+  }
+  bc_radix_sort (keys.data(), n, tmp.data());
+
+  std::vector<BCMath> sorted;
+  sorted.reserve (n);
+  for (size_t i = 0; i < n; i++) {
+    sorted.push_back (std::move (values[keys[i].index]));
+  }
+  values.swap (sorted);
+}
+
+void BCMath::bcscale (int scale) {
+  if (scale < 0) {
+    bc_default_context.scale = 0;
+  } else {
+    bc_default_context.scale = scale;
+  }
+}
+
+std::string BCMath::bcdiv (BCMath::View lhs, BCMath::View rhs, int scale) {
+  return Context::current().bcdiv (lhs, rhs, scale);
+}
+
+void BCMath::bcdiv_into (std::string &out, BCMath::View lhs, BCMath::View rhs, int scale) {
+  Context::current().bcdiv_into (out, lhs, rhs, scale);
+}
+
+std::string BCMath::bcmod (BCMath::View lhs, BCMath::View rhs) {
+  return Context::current().bcmod (lhs, rhs);
+}
+
+void BCMath::bcmod_into (std::string &out, BCMath::View lhs, BCMath::View rhs) {
+  Context::current().bcmod_into (out, lhs, rhs);
+}
+
+std::string BCMath::bcpow (BCMath::View lhs, BCMath::View rhs) {
+  return Context::current().bcpow (lhs, rhs);
+}
+
+void BCMath::bcpow_into (std::string &out, BCMath::View lhs, BCMath::View rhs) {
+  Context::current().bcpow_into (out, lhs, rhs);
+}
+
+std::string BCMath::bcadd (BCMath::View lhs, BCMath::View rhs, int scale) {
+  return Context::current().bcadd (lhs, rhs, scale);
+}
+
+void BCMath::bcadd_into (std::string &out, BCMath::View lhs, BCMath::View rhs, int scale) {
+  Context::current().bcadd_into (out, lhs, rhs, scale);
+}
+
+std::string BCMath::bcsub (BCMath::View lhs, BCMath::View rhs, int scale) {
+  return Context::current().bcsub (lhs, rhs, scale);
+}
+
+void BCMath::bcsub_into (std::string &out, BCMath::View lhs, BCMath::View rhs, int scale) {
+  Context::current().bcsub_into (out, lhs, rhs, scale);
+}
+
+std::string BCMath::bcmul (BCMath::View lhs, BCMath::View rhs, int scale) {
+  return Context::current().bcmul (lhs, rhs, scale);
+}
+
+void BCMath::bcmul_into (std::string &out, BCMath::View lhs, BCMath::View rhs, int scale) {
+  Context::current().bcmul_into (out, lhs, rhs, scale);
+}
+
+std::string BCMath::bcfma (BCMath::View lhs, BCMath::View rhs, BCMath::View addend, int scale) {
+  return Context::current().bcfma (lhs, rhs, addend, scale);
+}
+
+void BCMath::bcfma_into (std::string &out, BCMath::View lhs, BCMath::View rhs, BCMath::View addend, int scale) {
+  Context::current().bcfma_into (out, lhs, rhs, addend, scale);
+}
+
+std::string BCMath::bcdot (const std::vector<std::string> &lhs, const std::vector<std::string> &rhs, int scale) {
+  return Context::current().bcdot (lhs, rhs, scale);
+}
+
+void BCMath::bcdot_into (std::string &out, const std::vector<std::string> &lhs, const std::vector<std::string> &rhs, int scale) {
+  Context::current().bcdot_into (out, lhs, rhs, scale);
+}
+
+std::string BCMath::bcdot (const std::vector<View> &lhs, const std::vector<View> &rhs, int scale) {
+  return Context::current().bcdot (lhs, rhs, scale);
+}
+
+void BCMath::bcdot_into (std::string &out, const std::vector<View> &lhs, const std::vector<View> &rhs, int scale) {
+  Context::current().bcdot_into (out, lhs, rhs, scale);
+}
+
+std::string BCMath::bcdot (const std::vector<BCMath> &lhs, const std::vector<BCMath> &rhs, int scale) {
+  return Context::current().bcdot (lhs, rhs, scale);
+}
+
+void BCMath::bcdot_into (std::string &out, const std::vector<BCMath> &lhs, const std::vector<BCMath> &rhs, int scale) {
+  Context::current().bcdot_into (out, lhs, rhs, scale);
+}
+
+int BCMath::bccomp (BCMath::View lhs, BCMath::View rhs, int scale) {
+  return Context::current().bccomp (lhs, rhs, scale);
+}
+
+std::string BCMath::bcround (BCMath::View lhs, int scale) {
+  return Context::current().bcround (lhs, scale);
+}
+
+void BCMath::bcround_into (std::string &out, BCMath::View lhs, int scale) {
+  Context::current().bcround_into (out, lhs, scale);
+}
+
+void BCMath::Context::bcdiv_into (std::string &out, BCMath::View lhs, const Divisor &rhs, int scale) const {
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bcdiv");
+    scale = 0;
+  }
+  if (lhs.empty()) {
+    out = bc_zero (scale);
+    return;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcdiv is not a number");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &result = bc_res;
+  rhs.divide (l, scale, *this, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcdiv (BCMath::View lhs, const Divisor &rhs, int scale) const {
+  std::string result;
+  bcdiv_into (result, lhs, rhs, scale);
+  return result;
+}
+
+void BCMath::Context::bcdiv_into (std::string &out, BCMath::View lhs, BCMath::View rhs, int scale) const {
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bcdiv");
+    scale = 0;
+  }
+  if (lhs.empty()) {
+    out = bc_zero (scale);
+    return;
+  }
+  if (rhs.empty()) {
+    bc_error (*this, "Division by empty " + rhs.str() + " in function bcdiv");
+    out = bc_zero (scale);
+    return;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcdiv is not a number");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &r = bc_rhs;
+  if (bc_parse_number (rhs, r) < 0) {
+    bc_error (*this, "Second parameter \"" + rhs.str() + "\" in function bcdiv is not a number");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &result = bc_res;
+  bc_div (l, r, bc_work_scale (*this, scale), *this, result);
+  bc_apply_rounding (*this, scale, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcdiv (BCMath::View lhs, BCMath::View rhs, int scale) const {
+  std::string result;
+  bcdiv_into (result, lhs, rhs, scale);
+  return result;
+}
+
+void BCMath::Context::bcmod_into (std::string &out, BCMath::View lhs, BCMath::View rhs) const {
+  if (lhs.empty()) {
+    out = ZERO;
+    return;
+  }
+  if (rhs.empty()) {
+    bc_error (*this, "Modulo by empty " + rhs.str() + " in function bcmod");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcmod is not an integer");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &r = bc_rhs;
+  if (bc_parse_number (rhs, r) < 0) {
+    bc_error (*this, "Second parameter \"" + rhs.str() + "\" in function bcmod is not an integer");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &result = bc_res;
+  bc_mod (l, r, *this, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcmod (BCMath::View lhs, BCMath::View rhs) const {
+  std::string result;
+  bcmod_into (result, lhs, rhs);
+  return result;
+}
+
+void BCMath::Context::bcpow_into (std::string &out, BCMath::View lhs, BCMath::View rhs) const {
+  if (lhs.empty()) {
+    out = ZERO;
+    return;
+  }
+  if (rhs.empty()) {
+    out = ONE;
+    return;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcpow is not an integer");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &r = bc_rhs;
+  if (bc_parse_number (rhs, r) < 0) {
+    bc_error (*this, "Second parameter \"" + rhs.str() + "\" in function bcpow is not an integer");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &result = bc_res;
+  bc_pow (l, r, *this, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcpow (BCMath::View lhs, BCMath::View rhs) const {
+  std::string result;
+  bcpow_into (result, lhs, rhs);
+  return result;
+}
+
+void BCMath::Context::bcadd_into (std::string &out, BCMath::View lhs, BCMath::View rhs, int scale) const {
+  if (lhs.empty()) {
+    bcadd_into (out, ZERO, rhs, scale);
+    return;
+  }
+  if (rhs.empty()) {
+    bcadd_into (out, lhs, ZERO, scale);
+    return;
+  }
+
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bcadd");
+    scale = 0;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcadd is not a number");
+    out = bc_zero (scale);
+    return;
+  }
+
+  bc_num &r = bc_rhs;
+  if (bc_parse_number (rhs, r) < 0) {
+    bc_error (*this, "Second parameter \"" + rhs.str() + "\" in function bcadd is not a number");
+    out = bc_zero (scale);
+    return;
+  }
+
+  bc_num &result = bc_res;
+  bc_add (l, l.sign, r, r.sign, bc_work_scale (*this, scale), result);
+  bc_apply_rounding (*this, scale, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcadd (BCMath::View lhs, BCMath::View rhs, int scale) const {
+  std::string result;
+  bcadd_into (result, lhs, rhs, scale);
+  return result;
+}
+
+void BCMath::Context::bcsub_into (std::string &out, BCMath::View lhs, BCMath::View rhs, int scale) const {
+  if (lhs.empty()) {
+    bcsub_into (out, ZERO, rhs, scale);
+    return;
+  }
+  if (rhs.empty()) {
+    bcsub_into (out, lhs, ZERO, scale);
+    return;
+  }
+
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bcsub");
+    scale = 0;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcsub is not a number");
+    out = bc_zero (scale);
+    return;
+  }
+
+  bc_num &r = bc_rhs;
+  if (bc_parse_number (rhs, r) < 0) {
+    bc_error (*this, "Second parameter \"" + rhs.str() + "\" in function bcsub is not a number");
+    out = bc_zero (scale);
+    return;
+  }
+
+  bc_num &result = bc_res;
+  bc_add (l, l.sign, r, -r.sign, bc_work_scale (*this, scale), result);
+  bc_apply_rounding (*this, scale, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcsub (BCMath::View lhs, BCMath::View rhs, int scale) const {
+  std::string result;
+  bcsub_into (result, lhs, rhs, scale);
+  return result;
+}
+
+void BCMath::Context::bcmul_into (std::string &out, BCMath::View lhs, BCMath::View rhs, int scale) const {
+  if (lhs.empty()) {
+    bcmul_into (out, ZERO, rhs, scale);
+    return;
+  }
+  if (rhs.empty()) {
+    bcmul_into (out, lhs, ZERO, scale);
+    return;
+  }
+
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bcmul");
+    scale = 0;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcmul is not a number");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &r = bc_rhs;
+  if (bc_parse_number (rhs, r) < 0) {
+    bc_error (*this, "Second parameter \"" + rhs.str() + "\" in function bcmul is not a number");
+    out = ZERO;
+    return;
+  }
+
+  bc_num &result = bc_res;
+  bc_mul (l, r, bc_work_scale (*this, scale), result);
+  bc_apply_rounding (*this, scale, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcmul (BCMath::View lhs, BCMath::View rhs, int scale) const {
+  std::string result;
+  bcmul_into (result, lhs, rhs, scale);
+  return result;
+}
+
+void BCMath::Context::bcfma_into (std::string &out, BCMath::View lhs, BCMath::View rhs, BCMath::View addend, int scale) const {
+  if (lhs.empty()) {
+    bcfma_into (out, ZERO, rhs, addend, scale);
+    return;
+  }
+  if (rhs.empty()) {
+    bcfma_into (out, lhs, ZERO, addend, scale);
+    return;
+  }
+  if (addend.empty()) {
+    bcfma_into (out, lhs, rhs, ZERO, scale);
+    return;
+  }
+
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bcfma");
+    scale = 0;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcfma is not a number");
+    out = bc_zero (scale);
+    return;
+  }
+
+  bc_num &r = bc_rhs;
+  if (bc_parse_number (rhs, r) < 0) {
+    bc_error (*this, "Second parameter \"" + rhs.str() + "\" in function bcfma is not a number");
+    out = bc_zero (scale);
+    return;
+  }
+
+  //the product is kept whole, only the sum is brought to scale
+  bc_mul (l, r, l.scale + r.scale, l);
+
+  if (bc_parse_number (addend, r) < 0) {
+    bc_error (*this, "Third parameter \"" + addend.str() + "\" in function bcfma is not a number");
+    out = bc_zero (scale);
+    return;
+  }
+
+  bc_num &result = bc_res;
+  bc_add (l, l.sign, r, r.sign, bc_work_scale (*this, scale), result);
+  bc_apply_rounding (*this, scale, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcfma (BCMath::View lhs, BCMath::View rhs, BCMath::View addend, int scale) const {
+  std::string result;
+  bcfma_into (result, lhs, rhs, addend, scale);
+  return result;
+}
+
+//sums of products of bcdot, kept between calls for the capacity of their columns
+static thread_local BCMath::Accumulator bc_dot;
+
+template <class T>
+void BCMath::Context::bcdot_text (std::string &out, const std::vector<T> &lhs, const std::vector<T> &rhs, int scale) const {
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bcdot");
+    scale = 0;
+  }
+  if (lhs.size() != rhs.size()) {
+    bc_error (*this, "Parameters of function bcdot have different sizes");
+    out = bc_zero (scale);
+    return;
+  }
+
+  Accumulator &acc = bc_dot;
+  acc.clear();
+  bc_num &l = bc_lhs;
+  bc_num &r = bc_rhs;
+  for (size_t i = 0; i < lhs.size(); i++) {
+    View x (lhs[i]), y (rhs[i]);
+    if (x.empty() || y.empty()) {
+      continue;
+    }
+    if (bc_parse_number (x, l) < 0) {
+      bc_error (*this, "Element \"" + x.str() + "\" of the first parameter in function bcdot is not a number");
+      out = bc_zero (scale);
+      return;
+    }
+    if (bc_parse_number (y, r) < 0) {
+      bc_error (*this, "Element \"" + y.str() + "\" of the second parameter in function bcdot is not a number");
+      out = bc_zero (scale);
+      return;
+    }
+    acc.addmul (l, r);
+  }
+
+  bc_num &result = bc_res;
+  acc.finish (scale, *this, result);
+  bc_to_string (result, out);
+}
+
+void BCMath::Context::bcdot_into (std::string &out, const std::vector<std::string> &lhs, const std::vector<std::string> &rhs, int scale) const {
+  bcdot_text (out, lhs, rhs, scale);
+}
+
+std::string BCMath::Context::bcdot (const std::vector<std::string> &lhs, const std::vector<std::string> &rhs, int scale) const {
+  std::string result;
+  bcdot_into (result, lhs, rhs, scale);
+  return result;
+}
+
+void BCMath::Context::bcdot_into (std::string &out, const std::vector<View> &lhs, const std::vector<View> &rhs, int scale) const {
+  bcdot_text (out, lhs, rhs, scale);
+}
+
+std::string BCMath::Context::bcdot (const std::vector<View> &lhs, const std::vector<View> &rhs, int scale) const {
+  std::string result;
+  bcdot_into (result, lhs, rhs, scale);
+  return result;
+}
+
+void BCMath::Context::bcdot_into (std::string &out, const std::vector<BCMath> &lhs, const std::vector<BCMath> &rhs, int scale) const {
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bcdot");
+    scale = 0;
+  }
+  if (lhs.size() != rhs.size()) {
+    bc_error (*this, "Parameters of function bcdot have different sizes");
+    out = bc_zero (scale);
+    return;
+  }
+
+  Accumulator &acc = bc_dot;
+  acc.clear();
+  for (size_t i = 0; i < lhs.size(); i++) {
+    acc.addmul (lhs[i].value, rhs[i].value);
+  }
+
+  bc_num &result = bc_res;
+  acc.finish (scale, *this, result);
+  bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcdot (const std::vector<BCMath> &lhs, const std::vector<BCMath> &rhs, int scale) const {
+  std::string result;
+  bcdot_into (result, lhs, rhs, scale);
+  return result;
+}
+
+int BCMath::Context::bccomp (BCMath::View lhs, BCMath::View rhs, int scale) const {
+  if (lhs.empty()) {
+    return bccomp (ZERO, rhs, scale);
+  }
+  if (rhs.empty()) {
+    return bccomp (lhs, ZERO, scale);
+  }
+
+  if (scale == INT_MIN) {
+    scale = this->scale;
+  }
+  if (scale < 0) {
+    bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bccomp");
+    scale = 0;
+  }
+
+  bc_num &l = bc_lhs;
+  if (bc_parse_number (lhs, l) < 0) {
+    bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bccomp is not a number");
+    return 0;
+  }
+
+  bc_num &r = bc_rhs;
+  if (bc_parse_number (rhs, r) < 0) {
+    bc_error (*this, "Second parameter \"" + rhs.str() + "\" in function bccomp is not a number");
+    return 0;
+  }
+
+  return bc_compare (l, r, scale);
+}
+
+void BCMath::Context::bcround_into (std::string &out, BCMath::View lhs, int scale) const {
+    if (lhs.empty()) {
+      bcround_into (out, ZERO, scale);
+      return;
+    }
+
+    if (scale == INT_MIN) {
+      scale = this->scale;
+    }
+
+    if (scale < 0) {
+      bc_error (*this, "Wrong parameter scale = " + std::to_string (scale) + " in function bccomp");
+      scale = 0;
+    }
+
+    bc_num &l = bc_lhs;
+    if (bc_parse_number (lhs, l) < 0) {
+      bc_error (*this, "First parameter \"" + lhs.str() + "\" in function bcround is not a number");
+      out = ZERO;
+      return;
+    }
+
+    bc_num &result = bc_res;
+    bc_round (l, scale, result);
+    bc_to_string (result, out);
+}
+
+std::string BCMath::Context::bcround (BCMath::View lhs, int scale) const {
+  std::string result;
+  bcround_into (result, lhs, scale);
+  return result;
+}
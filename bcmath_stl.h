@@ -1,214 +1,748 @@
-#ifndef BCMATH_H
-#define BCMATH_H
-
-/*
-    This file is part of VK/KittenPHP-DB-Engine.
-
-    VK/KittenPHP-DB-Engine is free software: you can redistribute it and/or modify
-    it under the terms of the GNU General Public License as published by
-    the Free Software Foundation, either version 2 of the License, or
-    (at your option) any later version.
-
-    VK/KittenPHP-DB-Engine is distributed in the hope that it will be useful,
-    but WITHOUT ANY WARRANTY; without even the implied warranty of
-    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-    GNU General Public License for more details.
-
-    You should have received a copy of the GNU General Public License
-    along with VK/KittenPHP-DB-Engine.  If not, see <http://www.gnu.org/licenses/>.
-
-    This program is released under the GPL with the additional exemption
-    that compiling, linking, and/or using OpenSSL is allowed.
-    You are free to remove this exemption from derived works.
-
-    Copyright 2012-2013 Vkontakte Ltd
-              2012-2013 Arseny Smirnov
-              2012-2013 Aliaksei Levin
-
-    URL: https://github.com/vk-com/kphp-kdb/blob/master/KPHP/runtime/bcmath.h
-
-    Adapted to STL C++:
-        2014 Kijam Lopez B. <klopez@cuado.co>
-
-*/
-
-#include<string>
-#include<iostream>
-#include<sstream>
-
-class BCMath {
-
-public:
-    BCMath() { }
-    BCMath(const BCMath &o) : value(o.value) { }
-    BCMath(const char *num) : value(num) {  }
-    BCMath(std::string num) : value(num) {  }
-    BCMath(int num) : value() { std::stringstream ss; ss << num; value = ss.str(); }
-    BCMath(long long num) : value() { std::stringstream ss; ss << num; value = ss.str(); }
-    BCMath(unsigned int num) : value() { std::stringstream ss; ss << num; value = ss.str(); }
-    BCMath(unsigned long long num) : value() { std::stringstream ss; ss << num; value = ss.str(); }
-    BCMath(float num) : value() { std::stringstream ss; ss << num; value = ss.str(); }
-    BCMath(double num) : value() { std::stringstream ss; ss << num; value = ss.str(); }
-    BCMath(long double num) { std::stringstream ss; ss << num; value = ss.str(); }
-
-    BCMath operator+(const BCMath& o) {
-        return BCMath::bcadd(value, o.value);
-    }
-
-    BCMath operator-(const BCMath& o) {
-        return BCMath::bcsub(value, o.value);
-    }
-
-    BCMath operator*(const BCMath& o) {
-        return BCMath::bcmul(value, o.value);
-    }
-
-    BCMath operator/(const BCMath& o) {
-        return BCMath::bcdiv(value, o.value);
-    }
-
-    BCMath operator%(const BCMath& o) {
-        return BCMath::bcmod(value, o.value);
-    }
-
-    BCMath operator^(const BCMath& o) {
-        return BCMath::bcpow(value, o.value);
-    }
-
-    void operator+=(const BCMath& o) {
-        value = BCMath::bcadd(value, o.value);
-    }
-    void operator-=(const BCMath& o) {
-        value = BCMath::bcsub(value, o.value);
-    }
-    void operator*=(const BCMath& o) {
-        value = BCMath::bcmul(value, o.value);
-    }
-    void operator/=(const BCMath& o) {
-        value = BCMath::bcdiv(value, o.value);
-    }
-    void operator^=(const BCMath& o) {
-        value = BCMath::bcpow(value, o.value);
-    }
-
-    bool operator > (const BCMath& o) {
-        return BCMath::bccomp(value, o.value)>0;
-    }
-    bool operator >= (const BCMath& o) {
-        return BCMath::bccomp(value, o.value)>=0;
-    }
-    bool operator == (const BCMath& o) {
-        return BCMath::bccomp(value, o.value)==0;
-    }
-    bool operator < (const BCMath& o) {
-        return BCMath::bccomp(value, o.value)<0;
-    }
-    bool operator <= (const BCMath& o) {
-        return BCMath::bccomp(value, o.value)<=0;
-    }
-
-    int toInt() {
-        std::istringstream buffer(value);
-        int ret;
-        buffer >> ret;
-        return ret;
-    }
-
-    unsigned int toUInt() {
-        std::istringstream buffer(value);
-        unsigned int ret;
-        buffer >> ret;
-        return ret;
-    }
-
-    long long toLongLong() {
-        std::istringstream buffer(value);
-        long long ret;
-        buffer >> ret;
-        return ret;
-    }
-
-    unsigned long long toULongLong() {
-        std::istringstream buffer(value);
-        unsigned long long ret;
-        buffer >> ret;
-        return ret;
-    }
-
-    long double toLongDouble() {
-        std::istringstream buffer(value);
-        long double ret;
-        buffer >> ret;
-        return ret;
-    }
-
-    double toDouble() {
-        std::istringstream buffer(value);
-        double ret;
-        buffer >> ret;
-        return ret;
-    }
-
-    float toFloat() {
-        std::istringstream buffer(value);
-        float ret;
-        buffer >> ret;
-        return ret;
-    }
-
-    std::string toString() {
-        return value;
-    }
-
-    void round(int scale) {
-        if(scale>=1)
-            value = BCMath::bcround(value, scale);
-    }
-
-    std::string getIntPart() {
-        std::size_t dot = value.find('.');
-        if(dot != std::string::npos) {
-            if(dot == 0)
-                return std::string("0");
-            if(dot == 1 && value[0] == '-')
-                return std::string("-0");
-            return value.substr(0, dot);
-        }else{
-            return value;
-        }
-    }
-
-    std::string getDecPart() {
-        std::size_t dot = value.find('.');
-        if(dot != std::string::npos)
-            return value.length()>dot+1?value.substr(dot+1):std::string("0");
-        else
-            return std::string("0");
-    }
-
-private:
-    std::string value;
-
-public:
-    static void bcscale (int scale);
-
-    static std::string bcdiv (const std::string &lhs, const std::string &rhs, int scale = INT_MIN);
-
-    static std::string bcmod (const std::string &lhs, const std::string &rhs);
-
-    static std::string bcpow (const std::string &lhs, const std::string &rhs);
-
-    static std::string bcadd (const std::string &lhs, const std::string &rhs, int scale = INT_MIN);
-
-    static std::string bcsub (const std::string &lhs, const std::string &rhs, int scale = INT_MIN);
-
-    static std::string bcmul (const std::string &lhs, const std::string &rhs, int scale = INT_MIN);
-
-    static std::string bcround (const std::string &lhs, int scale = INT_MIN);
-
-    static int bccomp (const std::string &lhs, const std::string &rhs, int scale = INT_MIN);
-
-};
-
-
-#endif // BCMATH_H
+#ifndef BCMATH_H
+#define BCMATH_H
+
+/*
+    This file is part of VK/KittenPHP-DB-Engine.
+
+    VK/KittenPHP-DB-Engine is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    VK/KittenPHP-DB-Engine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with VK/KittenPHP-DB-Engine.  If not, see <http://www.gnu.org/licenses/>.
+
+    This program is released under the GPL with the additional exemption
+    that compiling, linking, and/or using OpenSSL is allowed.
+    You are free to remove this exemption from derived works.
+
+    Copyright 2012-2013 Vkontakte Ltd
+              2012-2013 Arseny Smirnov
+              2012-2013 Aliaksei Levin
+
+    URL: https://github.com/vk-com/kphp-kdb/blob/master/KPHP/runtime/bcmath.h
+
+    Adapted to STL C++:
+        2014 Kijam Lopez B. <klopez@cuado.co>
+
+*/
+
+#include<string>
+#include<cstring>
+#include<vector>
+#include<iostream>
+#include<climits>
+#include<utility>
+#include<type_traits>
+#if __cplusplus >= 201703L
+#include<string_view>
+#endif
+
+typedef unsigned int bc_limb;
+
+//number stored in base 1e9 limbs, least significant limb first; the lowest
+//(scale + 8) / 9 limbs hold the fractional part, digits below scale are zero
+struct bc_num {
+    int sign;
+    int scale;
+    std::vector<bc_limb> limbs;
+
+    bc_num() : sign(1), scale(0) { }
+};
+
+struct bc_mag;
+
+class BCMath {
+
+public:
+    class Divisor;
+
+    //text of a number read in place: a pointer and a length into a std::string, a
+    //C string, a std::string_view or any buffer, which must outlive the view
+    class View {
+    public:
+        View(const char *s) : s(s), len(strlen(s)) { }
+        View(const char *s, size_t len) : s(s), len(len) { }
+        View(const std::string &s) : s(s.data()), len(s.size()) { }
+#if __cplusplus >= 201703L
+        View(std::string_view s) : s(s.data()), len(s.size()) { }
+#endif
+
+        const char *data() const { return s; }
+        size_t size() const { return len; }
+        bool empty() const { return len == 0; }
+        std::string str() const { return std::string(s, len); }
+
+    private:
+        const char *s;
+        size_t len;
+    };
+
+    //scale, rounding and error policy of the bc functions and operators; a
+    //context can be used explicitly through its bc* methods or installed for
+    //the current thread with Scope, otherwise the process default set by
+    //bcscale applies
+    class Context {
+    public:
+        //TRUNCATE keeps the digits up to scale, HALF_UP rounds half away from zero
+        enum Rounding { TRUNCATE, HALF_UP };
+        //REPORT prints errors to std::cerr, SILENT drops them, THROW raises std::runtime_error
+        enum Errors { REPORT, SILENT, THROW };
+
+        int scale;
+        Rounding rounding;
+        Errors errors;
+
+        //constexpr so that the process default context is initialised before any
+        //static initialiser that might use it
+        constexpr explicit Context(int scale, Rounding rounding = TRUNCATE, Errors errors = REPORT)
+            : scale(scale < 0 ? 0 : scale), rounding(rounding), errors(errors) { }
+
+        static const Context &current();
+
+        class Scope;
+
+        std::string bcdiv (View lhs, View rhs, int scale = INT_MIN) const;
+
+        void bcdiv_into (std::string &out, View lhs, View rhs, int scale = INT_MIN) const;
+
+        std::string bcdiv (View lhs, const Divisor &rhs, int scale = INT_MIN) const;
+
+        void bcdiv_into (std::string &out, View lhs, const Divisor &rhs, int scale = INT_MIN) const;
+
+        std::string bcmod (View lhs, View rhs) const;
+
+        void bcmod_into (std::string &out, View lhs, View rhs) const;
+
+        std::string bcpow (View lhs, View rhs) const;
+
+        void bcpow_into (std::string &out, View lhs, View rhs) const;
+
+        std::string bcadd (View lhs, View rhs, int scale = INT_MIN) const;
+
+        void bcadd_into (std::string &out, View lhs, View rhs, int scale = INT_MIN) const;
+
+        std::string bcsub (View lhs, View rhs, int scale = INT_MIN) const;
+
+        void bcsub_into (std::string &out, View lhs, View rhs, int scale = INT_MIN) const;
+
+        std::string bcmul (View lhs, View rhs, int scale = INT_MIN) const;
+
+        void bcmul_into (std::string &out, View lhs, View rhs, int scale = INT_MIN) const;
+
+        std::string bcfma (View lhs, View rhs, View addend, int scale = INT_MIN) const;
+
+        void bcfma_into (std::string &out, View lhs, View rhs, View addend, int scale = INT_MIN) const;
+
+        std::string bcdot (const std::vector<std::string> &lhs, const std::vector<std::string> &rhs, int scale = INT_MIN) const;
+
+        void bcdot_into (std::string &out, const std::vector<std::string> &lhs, const std::vector<std::string> &rhs, int scale = INT_MIN) const;
+
+        std::string bcdot (const std::vector<View> &lhs, const std::vector<View> &rhs, int scale = INT_MIN) const;
+
+        void bcdot_into (std::string &out, const std::vector<View> &lhs, const std::vector<View> &rhs, int scale = INT_MIN) const;
+
+        std::string bcdot (const std::vector<BCMath> &lhs, const std::vector<BCMath> &rhs, int scale = INT_MIN) const;
+
+        void bcdot_into (std::string &out, const std::vector<BCMath> &lhs, const std::vector<BCMath> &rhs, int scale = INT_MIN) const;
+
+        std::string bcround (View lhs, int scale = INT_MIN) const;
+
+        void bcround_into (std::string &out, View lhs, int scale = INT_MIN) const;
+
+        int bccomp (View lhs, View rhs, int scale = INT_MIN) const;
+
+    private:
+        template <class T>
+        void bcdot_text (std::string &out, const std::vector<T> &lhs, const std::vector<T> &rhs, int scale) const;
+    };
+
+    //installs a copy of a context for the current thread until destroyed
+    class Context::Scope {
+    public:
+        explicit Scope(const Context &context);
+        ~Scope();
+
+    private:
+        Context context;
+        const Context *previous;
+
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+    };
+
+    //divisor prepared once for many divisions by the same value: the normalised
+    //divisor and the inverse of its top limb, or for long divisors a full
+    //reciprocal, are computed up front
+    class Divisor {
+    public:
+        explicit Divisor(const BCMath &divisor);
+
+        std::string bcdiv(View lhs, int scale = INT_MIN) const;
+
+        void bcdiv_into(std::string &out, View lhs, int scale = INT_MIN) const;
+
+    private:
+        friend class BCMath;
+
+        int sign;
+        int frac;
+        int low;
+        std::vector<bc_limb> limbs;
+        std::vector<bc_limb> normalised;
+        std::vector<bc_limb> recip;
+        bc_limb norm;
+        unsigned long long inv;
+
+        void divide(const bc_num &lhs, int scale, const Context &ctx, bc_num &result) const;
+    };
+
+    //exact sum of many numbers: the limbs of every operand are added into signed
+    //64 bit columns aligned to the decimal point and the carries are resolved only
+    //now and then, so an add is one pass over the limbs of its operand. Nothing is
+    //truncated until result, which rounds once with the current context
+    class Accumulator {
+    public:
+        Accumulator() : frac(0), pending(0) { }
+
+        void add(const BCMath &x);
+
+        void add(const std::string &x);
+
+        void add(const char *x);
+
+        void add(View x);
+
+        //adds the exact product lhs * rhs
+        void addmul(const BCMath &lhs, const BCMath &rhs);
+
+        void clear();
+
+        BCMath result(int scale = INT_MIN) const;
+
+    private:
+        friend class BCMath;
+
+        std::vector<long long> cols;
+        int frac;
+        unsigned long long pending;
+
+        void add(const bc_mag &x, int sign);
+        void add(const bc_num &x);
+        void addmul(const bc_num &lhs, const bc_num &rhs);
+        void normalise();
+        void finish(int scale, const Context &ctx, bc_num &result) const;
+    };
+
+    //a number in the binary form of serialize read in place, e.g. straight out of a
+    //receive buffer or a mapped file, which must outlive the view. The bytes are
+    //checked once on construction and not copied; each operator decodes the limb
+    //varints into per-thread registers, with no text parsing and no further checks,
+    //and rounds with the current context like those of BCMath. Bytes that are not a
+    //valid encoding are reported and read as zero
+    class Encoded {
+    public:
+        Encoded(const char *data, size_t len);
+
+        bool valid() const { return ok; }
+        //bytes taken by the number, which may be followed by others in the buffer
+        size_t size() const { return bytes; }
+        BCMath value() const;
+
+        BCMath operator+(const Encoded &o) const;
+        BCMath operator-(const Encoded &o) const;
+        BCMath operator*(const Encoded &o) const;
+        BCMath operator/(const Encoded &o) const;
+
+        bool operator > (const Encoded &o) const { return compare(o) > 0; }
+        bool operator >= (const Encoded &o) const { return compare(o) >= 0; }
+        bool operator == (const Encoded &o) const { return compare(o) == 0; }
+        bool operator != (const Encoded &o) const { return compare(o) != 0; }
+        bool operator < (const Encoded &o) const { return compare(o) < 0; }
+        bool operator <= (const Encoded &o) const { return compare(o) <= 0; }
+
+    private:
+        const unsigned char *limbs;
+        int len;
+        int scale;
+        int sign;
+        size_t bytes;
+        bool ok;
+
+        void load(bc_num &num) const;
+        int compare(const Encoded &o) const;
+    };
+
+    //lazy expressions: the operators applied to lazy(x) build an expression tree
+    //that is evaluated in one pass when it is assigned to a BCMath. Intermediate
+    //values go to per-thread registers instead of BCMath temporaries, the leaves
+    //are used as already parsed, and the result equals that of the eager
+    //operators. The tree refers to its operands, so assign it in the statement
+    //that builds it, e.g. BCMath r = BCMath::lazy(a) * b + BCMath::lazy(c) * d - e;
+    struct LazyExpr;
+    struct LazyLeaf;
+    template <class L, class R, char Op> struct LazyNode;
+
+    template <class T, class = void>
+    struct LazyOperand { };
+
+    template <class T>
+    struct LazyOperand<T, typename std::enable_if<std::is_base_of<LazyExpr, T>::value>::type> {
+        typedef T type;
+        static const T &wrap(const T &x) { return x; }
+    };
+
+    template <class T>
+    struct LazyOperand<T, typename std::enable_if<std::is_same<T, BCMath>::value>::type> {
+        typedef LazyLeaf type;
+        static LazyLeaf wrap(const BCMath &x) { return LazyLeaf(x); }
+    };
+
+    template <class L, class R, char Op, class = void>
+    struct LazyResult { };
+
+    template <class L, class R, char Op>
+    struct LazyResult<L, R, Op, typename std::enable_if<
+            (std::is_base_of<LazyExpr, L>::value || std::is_base_of<LazyExpr, R>::value) &&
+            sizeof(typename LazyOperand<L>::type) != 0 && sizeof(typename LazyOperand<R>::type) != 0>::type> {
+        typedef LazyNode<typename LazyOperand<L>::type, typename LazyOperand<R>::type, Op> type;
+
+        static type make(const L &l, const R &r) {
+            return type(LazyOperand<L>::wrap(l), LazyOperand<R>::wrap(r));
+        }
+    };
+
+    //register for an intermediate value, taken from the thread's pool when first used
+    class LazyReg {
+    public:
+        LazyReg() : num(0) { }
+        ~LazyReg() {
+            if (num)
+                lazy_release();
+        }
+
+        bc_num &get() {
+            if (!num)
+                num = &lazy_acquire();
+            return *num;
+        }
+
+    private:
+        bc_num *num;
+
+        LazyReg(const LazyReg &);
+        LazyReg &operator=(const LazyReg &);
+    };
+
+    struct LazyExpr {
+        template <class L, class R>
+        friend typename LazyResult<L, R, '+'>::type operator+(const L &l, const R &r) {
+            return LazyResult<L, R, '+'>::make(l, r);
+        }
+        template <class L, class R>
+        friend typename LazyResult<L, R, '-'>::type operator-(const L &l, const R &r) {
+            return LazyResult<L, R, '-'>::make(l, r);
+        }
+        template <class L, class R>
+        friend typename LazyResult<L, R, '*'>::type operator*(const L &l, const R &r) {
+            return LazyResult<L, R, '*'>::make(l, r);
+        }
+        template <class L, class R>
+        friend typename LazyResult<L, R, '/'>::type operator/(const L &l, const R &r) {
+            return LazyResult<L, R, '/'>::make(l, r);
+        }
+    };
+
+    struct LazyLeaf : LazyExpr {
+        const bc_num &num;
+
+        explicit LazyLeaf(const BCMath &x) : num(x.value) { }
+
+        const bc_num &ref(LazyReg &) const {
+            return num;
+        }
+        void eval(bc_num &result) const {
+            result = num;
+        }
+    };
+
+    template <class L, class R, char Op>
+    struct LazyNode : LazyExpr {
+        L lhs;
+        R rhs;
+
+        LazyNode(const L &lhs, const R &rhs) : lhs(lhs), rhs(rhs) { }
+
+        const bc_num &ref(LazyReg &reg) const {
+            bc_num &num = reg.get();
+            eval(num);
+            return num;
+        }
+
+        //both operands are evaluated before result is written, so result may be a leaf
+        void eval(bc_num &result) const {
+            LazyReg lreg, rreg;
+            const bc_num &l = lhs.ref(lreg);
+            const bc_num &r = rhs.ref(rreg);
+            switch (Op) {
+            case '+': add(l, r, 1, result); break;
+            case '-': add(l, r, -1, result); break;
+            case '*': mul(l, r, result); break;
+            case '/': div(l, r, result); break;
+            }
+        }
+    };
+
+    static LazyLeaf lazy(const BCMath &x) {
+        return LazyLeaf(x);
+    }
+
+    //the exact value of a floating point number, every digit of its binary
+    //expansion, e.g. exact(0.1) is 0.1000000000000000055511151231257827021181583404541015625
+    static BCMath exact(float num);
+    static BCMath exact(double num);
+    static BCMath exact(long double num);
+
+    BCMath() { }
+    BCMath(const BCMath &o) : value(o.value) { }
+    BCMath(BCMath &&o) noexcept : value(std::move(o.value)) { }
+    //text is parsed once here; text that is not a number is reported and taken as 0
+    BCMath(const char *num) { parse(num); }
+    BCMath(const std::string &num) { parse(num); }
+    BCMath(View num) { parse(num); }
+    BCMath(int num) { assign(num < 0 ? 0 - (unsigned long long)num : num, num < 0 ? -1 : 1); }
+    BCMath(long long num) { assign(num < 0 ? 0 - (unsigned long long)num : num, num < 0 ? -1 : 1); }
+    BCMath(unsigned int num) { assign(num, 1); }
+    BCMath(unsigned long long num) { assign(num, 1); }
+    //a floating point value becomes the shortest decimal that converts back to it
+    BCMath(float num) { assign(num); }
+    BCMath(double num) { assign(num); }
+    BCMath(long double num) { assign(num); }
+
+    BCMath &operator=(const BCMath &o) {
+        value = o.value;
+        return *this;
+    }
+
+    BCMath &operator=(BCMath &&o) noexcept {
+        value = std::move(o.value);
+        return *this;
+    }
+
+    template <class E, class = typename std::enable_if<std::is_base_of<LazyExpr, E>::value>::type>
+    BCMath(const E &e) { e.eval(value); }
+
+    template <class E>
+    typename std::enable_if<std::is_base_of<LazyExpr, E>::value, BCMath &>::type operator=(const E &e) {
+        e.eval(value);
+        return *this;
+    }
+
+    //the && overloads compute into the limbs of a temporary left operand, so
+    //chains like a * b + c reuse one buffer
+    BCMath operator+(const BCMath& o) const & {
+        BCMath result;
+        add(value, o.value, 1, result.value);
+        return result;
+    }
+    BCMath operator+(const BCMath& o) && {
+        add(value, o.value, 1, value);
+        return std::move(*this);
+    }
+
+    BCMath operator-(const BCMath& o) const & {
+        BCMath result;
+        add(value, o.value, -1, result.value);
+        return result;
+    }
+    BCMath operator-(const BCMath& o) && {
+        add(value, o.value, -1, value);
+        return std::move(*this);
+    }
+
+    BCMath operator*(const BCMath& o) const & {
+        BCMath result;
+        mul(value, o.value, result.value);
+        return result;
+    }
+    BCMath operator*(const BCMath& o) && {
+        mul(value, o.value, value);
+        return std::move(*this);
+    }
+
+    BCMath operator/(const BCMath& o) const & {
+        BCMath result;
+        div(value, o.value, result.value);
+        return result;
+    }
+    BCMath operator/(const BCMath& o) && {
+        div(value, o.value, value);
+        return std::move(*this);
+    }
+
+    BCMath operator/(const Divisor& o) const & {
+        BCMath result;
+        div(value, o, result.value);
+        return result;
+    }
+    BCMath operator/(const Divisor& o) && {
+        div(value, o, value);
+        return std::move(*this);
+    }
+
+    BCMath operator%(const BCMath& o) const & {
+        BCMath result;
+        mod(value, o.value, result.value);
+        return result;
+    }
+    BCMath operator%(const BCMath& o) && {
+        mod(value, o.value, value);
+        return std::move(*this);
+    }
+
+    BCMath operator^(const BCMath& o) const & {
+        BCMath result;
+        pow(value, o.value, result.value);
+        return result;
+    }
+    BCMath operator^(const BCMath& o) && {
+        pow(value, o.value, value);
+        return std::move(*this);
+    }
+
+    BCMath &operator+=(const BCMath& o) {
+        add(value, o.value, 1, value);
+        return *this;
+    }
+    BCMath &operator-=(const BCMath& o) {
+        add(value, o.value, -1, value);
+        return *this;
+    }
+    BCMath &operator*=(const BCMath& o) {
+        mul(value, o.value, value);
+        return *this;
+    }
+    BCMath &operator/=(const BCMath& o) {
+        div(value, o.value, value);
+        return *this;
+    }
+    BCMath &operator/=(const Divisor& o) {
+        div(value, o, value);
+        return *this;
+    }
+    BCMath &operator%=(const BCMath& o) {
+        mod(value, o.value, value);
+        return *this;
+    }
+    BCMath &operator^=(const BCMath& o) {
+        pow(value, o.value, value);
+        return *this;
+    }
+
+    bool operator > (const BCMath& o) const {
+        return comp(value, o.value)>0;
+    }
+    bool operator >= (const BCMath& o) const {
+        return comp(value, o.value)>=0;
+    }
+    bool operator == (const BCMath& o) const {
+        return comp(value, o.value)==0;
+    }
+    bool operator != (const BCMath& o) const {
+        return comp(value, o.value)!=0;
+    }
+    bool operator < (const BCMath& o) const {
+        return comp(value, o.value)<0;
+    }
+    bool operator <= (const BCMath& o) const {
+        return comp(value, o.value)<=0;
+    }
+
+    //conversions to native types, the integer ones drop the fraction. A value out of
+    //the range of the type is reported through the error policy of the context, or by
+    //a false return from the overloads that store it in result; the integer types
+    //clamp it to their range and the floating point ones overflow to +-infinity
+    int toInt() const;
+    bool toInt(int &result) const;
+
+    unsigned int toUInt() const;
+    bool toUInt(unsigned int &result) const;
+
+    long long toLongLong() const;
+    bool toLongLong(long long &result) const;
+
+    unsigned long long toULongLong() const;
+    bool toULongLong(unsigned long long &result) const;
+
+    long double toLongDouble() const;
+    bool toLongDouble(long double &result) const;
+
+    double toDouble() const;
+    bool toDouble(double &result) const;
+
+    float toFloat() const;
+    bool toFloat(float &result) const;
+
+    std::string toString() const;
+
+    //writes the text of toString to [first, last) and returns the end of it, or
+    //NULL without writing anything if it does not fit; it is toStringLength long
+    char *to_chars(char *first, char *last) const;
+
+    size_t toStringLength() const;
+
+    //compact binary form, versioned by its first byte. The second byte holds the sign
+    //and the number of integer limbs and the scale when they are small, larger ones
+    //follow as varints; then come the base 10^9 limbs of the value as varints, least
+    //significant first, the lowest without its zeros below the scale. serialize
+    //appends it to out or writes it to [first, last) like to_chars; it is
+    //serializedLength long
+    void serialize(std::string &out) const;
+    char *serialize(char *first, char *last) const;
+    size_t serializedLength() const;
+
+    //the number encoded in exactly [data, data + len), zero if it is not valid
+    static BCMath deserialize(const char *data, size_t len);
+
+    //byte key whose memcmp order is the numeric order, for sorting and for the keys
+    //of ordered stores. The order is exact at every digit, unlike the comparison
+    //operators, which stop at the scale of the context, so numbers that differ only
+    //in trailing zeros share a key. Keys end themselves and can be concatenated.
+    //toKey appends the key to out; fromKey reads it back with the trailing zeros
+    //of the fraction dropped, or zero if [data, data + len) is not exactly a key
+    void toKey(std::string &out) const;
+    std::string toKey() const;
+    size_t keyLength() const;
+    static BCMath fromKey(const char *data, size_t len);
+
+    //stable sort by exact value, an MSD radix sort over the keys of the values
+    static void sort(std::vector<BCMath> &values);
+
+    void round(int scale) {
+        if(scale>=1)
+            round(value, scale, value);
+    }
+
+    std::string getIntPart() const {
+        std::string value = toString();
+        std::size_t dot = value.find('.');
+        if(dot != std::string::npos) {
+            if(dot == 0)
+                return std::string("0");
+            if(dot == 1 && value[0] == '-')
+                return std::string("-0");
+            return value.substr(0, dot);
+        }else{
+            return value;
+        }
+    }
+
+    std::string getDecPart() const {
+        std::string value = toString();
+        std::size_t dot = value.find('.');
+        if(dot != std::string::npos)
+            return value.length()>dot+1?value.substr(dot+1):std::string("0");
+        else
+            return std::string("0");
+    }
+
+private:
+    bc_num value;
+
+    void parse(View num);
+
+    void assign(unsigned long long magnitude, int sign);
+
+    void assign(float num);
+
+    void assign(double num);
+
+    void assign(long double num);
+
+    static void add(const bc_num &lhs, const bc_num &rhs, int rsign, bc_num &result);
+
+    static void mul(const bc_num &lhs, const bc_num &rhs, bc_num &result);
+
+    static void div(const bc_num &lhs, const bc_num &rhs, bc_num &result);
+
+    static void div(const bc_num &lhs, const Divisor &rhs, bc_num &result);
+
+    static void mod(const bc_num &lhs, const bc_num &rhs, bc_num &result);
+
+    static void pow(const bc_num &lhs, const bc_num &rhs, bc_num &result);
+
+    static void round(const bc_num &lhs, int scale, bc_num &result);
+
+    static int comp(const bc_num &lhs, const bc_num &rhs);
+
+    static bc_num &lazy_acquire();
+
+    static void lazy_release();
+
+public:
+    //sets the scale of the process default context
+    static void bcscale (int scale);
+
+    //each *_into function stores its result in out instead of returning it, so a
+    //loop that reuses out does not allocate once out is long enough
+    static std::string bcdiv (View lhs, View rhs, int scale = INT_MIN);
+
+    static void bcdiv_into (std::string &out, View lhs, View rhs, int scale = INT_MIN);
+
+    static std::string bcmod (View lhs, View rhs);
+
+    static void bcmod_into (std::string &out, View lhs, View rhs);
+
+    static std::string bcpow (View lhs, View rhs);
+
+    static void bcpow_into (std::string &out, View lhs, View rhs);
+
+    static std::string bcadd (View lhs, View rhs, int scale = INT_MIN);
+
+    static void bcadd_into (std::string &out, View lhs, View rhs, int scale = INT_MIN);
+
+    static std::string bcsub (View lhs, View rhs, int scale = INT_MIN);
+
+    static void bcsub_into (std::string &out, View lhs, View rhs, int scale = INT_MIN);
+
+    static std::string bcmul (View lhs, View rhs, int scale = INT_MIN);
+
+    static void bcmul_into (std::string &out, View lhs, View rhs, int scale = INT_MIN);
+
+    //lhs * rhs + addend with the exact product, rounded once to scale
+    static std::string bcfma (View lhs, View rhs, View addend, int scale = INT_MIN);
+
+    static void bcfma_into (std::string &out, View lhs, View rhs, View addend, int scale = INT_MIN);
+
+    //sum of lhs[i] * rhs[i] with exact products, rounded once to scale
+    static std::string bcdot (const std::vector<std::string> &lhs, const std::vector<std::string> &rhs, int scale = INT_MIN);
+
+    static void bcdot_into (std::string &out, const std::vector<std::string> &lhs, const std::vector<std::string> &rhs, int scale = INT_MIN);
+
+    static std::string bcdot (const std::vector<View> &lhs, const std::vector<View> &rhs, int scale = INT_MIN);
+
+    static void bcdot_into (std::string &out, const std::vector<View> &lhs, const std::vector<View> &rhs, int scale = INT_MIN);
+
+    static std::string bcdot (const std::vector<BCMath> &lhs, const std::vector<BCMath> &rhs, int scale = INT_MIN);
+
+    static void bcdot_into (std::string &out, const std::vector<BCMath> &lhs, const std::vector<BCMath> &rhs, int scale = INT_MIN);
+
+    static std::string bcround (View lhs, int scale = INT_MIN);
+
+    static void bcround_into (std::string &out, View lhs, int scale = INT_MIN);
+
+    static int bccomp (View lhs, View rhs, int scale = INT_MIN);
+
+};
+
+//std::vector<BCMath> moves its elements when it grows only if this holds
+static_assert(std::is_nothrow_move_constructible<BCMath>::value, "BCMath must be nothrow move constructible");
+static_assert(std::is_nothrow_move_assignable<BCMath>::value, "BCMath must be nothrow move assignable");
+
+
+#endif // BCMATH_H